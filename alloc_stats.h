@@ -0,0 +1,104 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+
+// Allocation accounting. Build with -DLEXER_ALLOC_STATS to replace the
+// global operator new and delete with versions that count allocations,
+// bytes, live bytes and the peak of live bytes. Without it nothing is
+// replaced, and readAllocations() returns zeros. Like the rest of the
+// project, this assumes the program is a single translation unit.
+
+// Struct to hold a snapshot of the allocation counters
+struct AllocationTotals {
+    uint64_t count;             // Allocations so far
+    uint64_t bytes;             // Bytes requested so far
+    uint64_t liveBytes;         // Bytes allocated and not yet freed
+    uint64_t peakLiveBytes;     // Highest liveBytes since the last resetAllocationPeak()
+
+    AllocationTotals()
+        : count(0)
+        , bytes(0)
+        , liveBytes(0)
+        , peakLiveBytes(0)
+    {
+    }
+};
+
+#ifdef LEXER_ALLOC_STATS
+
+constexpr bool allocationTracking = true;
+
+inline atomic<uint64_t> allocationCount(0);
+inline atomic<uint64_t> allocatedBytes(0);
+inline atomic<uint64_t> liveAllocatedBytes(0);
+inline atomic<uint64_t> peakAllocatedBytes(0);
+
+// Each block starts with a header holding its size, padded so the memory
+// after it keeps malloc's alignment
+constexpr size_t allocationHeader = alignof(max_align_t);
+
+void* operator new(size_t size)
+{
+    void* block = malloc(size + allocationHeader);
+    if (block == nullptr)
+        throw bad_alloc();
+    *static_cast<size_t*>(block) = size;
+
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    uint64_t live = liveAllocatedBytes.fetch_add(size, memory_order_relaxed) + size;
+    uint64_t peak = peakAllocatedBytes.load(memory_order_relaxed);
+    while (live > peak && !peakAllocatedBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {
+    }
+    return static_cast<char*>(block) + allocationHeader;
+}
+
+void operator delete(void* memory) noexcept
+{
+    if (memory == nullptr)
+        return;
+    void* block = static_cast<char*>(memory) - allocationHeader;
+    liveAllocatedBytes.fetch_sub(*static_cast<size_t*>(block), memory_order_relaxed);
+    free(block);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* memory) noexcept { operator delete(memory); }
+void operator delete(void* memory, size_t) noexcept { operator delete(memory); }
+void operator delete[](void* memory, size_t) noexcept { operator delete(memory); }
+
+// Function to read the allocation counters
+AllocationTotals readAllocations()
+{
+    AllocationTotals totals;
+    totals.count = allocationCount.load(memory_order_relaxed);
+    totals.bytes = allocatedBytes.load(memory_order_relaxed);
+    totals.liveBytes = liveAllocatedBytes.load(memory_order_relaxed);
+    totals.peakLiveBytes = peakAllocatedBytes.load(memory_order_relaxed);
+    return totals;
+}
+
+// Function to start measuring the peak of live bytes from the current level
+void resetAllocationPeak()
+{
+    peakAllocatedBytes.store(liveAllocatedBytes.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+#else
+
+constexpr bool allocationTracking = false;
+
+AllocationTotals readAllocations() { return AllocationTotals(); }
+void resetAllocationPeak() {}
+
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+
+// Class that hands out memory by bumping a pointer through large blocks.
+// Nothing is freed individually: all of it goes at once when the arena is
+// reset or destroyed, and memory never moves, so views into it stay valid
+// for the arena's lifetime.
+class MonotonicArena {
+private:
+    vector<unique_ptr<char[]>> blocks;
+    size_t blockSize;
+    size_t used;            // Bytes used in the last block
+    char* last;             // Most recent allocation, if it came from the last block
+    char* current;          // Block being filled (always the last one), if any
+
+public:
+
+    explicit MonotonicArena(size_t blockSize = 64 * 1024)
+        : blockSize(blockSize)
+        , used(blockSize)
+        , last(nullptr)
+        , current(nullptr)
+    {
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // Function to get uninitialized memory for size bytes (byte-aligned)
+    char* allocate(size_t size)
+    {
+        // Large requests get a block of their own, placed behind the
+        // current block so it keeps filling up
+        if (size > blockSize / 4) {
+            blocks.emplace_back(new char[size]);
+            char* memory = blocks.back().get();
+            if (blocks.size() > 1)
+                swap(blocks[blocks.size() - 1], blocks[blocks.size() - 2]);
+            else
+                used = blockSize;
+            last = nullptr;
+            return memory;
+        }
+        if (used + size > blockSize) {
+            blocks.emplace_back(new char[blockSize]);
+            current = blocks.back().get();
+            used = 0;
+        }
+        last = blocks.back().get() + used;
+        used += size;
+        return last;
+    }
+
+    // Function to give back the unused end of the most recent allocation
+    void shrink(char* memory, size_t allocated, size_t needed)
+    {
+        if (memory == last && needed <= allocated)
+            used -= allocated - needed;
+    }
+
+    // Function to release everything allocated so far. The block being
+    // filled is kept for reuse, so an arena that is reset between small
+    // jobs stops allocating once it has warmed up.
+    void reset()
+    {
+        if (current != nullptr) {
+            unique_ptr<char[]> kept = move(blocks.back());
+            blocks.clear();
+            blocks.push_back(move(kept));
+            used = 0;
+        }
+        else {
+            blocks.clear();
+            used = blockSize;
+        }
+        last = nullptr;
+    }
+
+    // Function to get the number of bytes held by the arena
+    size_t capacity() const { return blocks.size() * blockSize; }
+};
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <array>
+#include <filesystem>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "tokenization.h"
+#include "work_stealing.h"
+
+using namespace std;
+
+
+// Struct to hold the options of a multi-file run
+struct BatchOptions {
+    unsigned threads;
+    vector<string> extensions;  // File extensions picked up when walking directories
+
+    BatchOptions()
+        : threads(max(1u, thread::hardware_concurrency()))
+        , extensions({ ".cpp", ".cc", ".cxx", ".c", ".hpp", ".hh", ".hxx", ".h", ".txt" })
+    {
+    }
+};
+
+// Struct to hold what was found in one file of a multi-file run
+struct FileResult {
+    string path;
+    bool opened;
+    size_t bytes;
+    size_t tokenCount;
+    array<size_t, tokenTypeCount> countsByType;
+
+    FileResult()
+        : opened(false)
+        , bytes(0)
+        , tokenCount(0)
+        , countsByType()
+    {
+    }
+};
+
+// Function to check if a path has one of the wanted extensions
+bool hasWantedExtension(const filesystem::path& path, const vector<string>& extensions)
+{
+    string extension = path.extension().string();
+    return find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+// Function to add one command-line argument to the file list. Directories
+// are walked recursively and a leading '@' names a manifest with one path
+// per line. Directory contents are sorted so runs are reproducible. A
+// directory or manifest that can't be read is reported and skipped, and
+// the rest of the walk goes on, as is a manifest that lists itself through
+// any chain of manifests. Returns false if anything was skipped.
+bool addBatchPath(const string& argument, const BatchOptions& options, vector<string>& files,
+                  set<string>* expanding = nullptr)
+{
+    if (!argument.empty() && argument[0] == '@') {
+        string manifestPath = argument.substr(1);
+        ifstream manifest(manifestPath);
+        if (!manifest) {
+            cerr << "Error: Manifest " << manifestPath << " could not be opened." << endl;
+            return false;
+        }
+
+        // Track the manifests being expanded by their canonical paths
+        set<string> outermost;
+        if (expanding == nullptr)
+            expanding = &outermost;
+        error_code error;
+        string canonical = filesystem::weakly_canonical(manifestPath, error).string();
+        if (error)
+            canonical = manifestPath;
+        if (!expanding->insert(canonical).second) {
+            cerr << "Error: Manifest " << manifestPath << " includes itself." << endl;
+            return false;
+        }
+
+        bool complete = true;
+        string line;
+        while (getline(manifest, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                complete = addBatchPath(line, options, files, expanding) && complete;
+        }
+        expanding->erase(canonical);
+        return complete;
+    }
+
+    error_code error;
+    if (!filesystem::is_directory(argument, error)) {
+        files.push_back(argument);
+        return true;
+    }
+
+    bool complete = true;
+    vector<string> found;
+    filesystem::recursive_directory_iterator it(argument, filesystem::directory_options::skip_permission_denied, error);
+    for (filesystem::recursive_directory_iterator end; !error && it != end; it.increment(error)) {
+        const filesystem::path& path = it->path();
+        error_code entryError;
+        if (it->is_directory(entryError)) {
+            // Check a subdirectory opens before going into it, since a
+            // failed step would end the whole walk
+            filesystem::directory_iterator probe(path, entryError);
+            if (entryError) {
+                cerr << "Error: Directory " << path.string() << " could not be read: " << entryError.message() << endl;
+                complete = false;
+                it.disable_recursion_pending();
+            }
+        }
+        else if (it->is_regular_file(entryError) && hasWantedExtension(path, options.extensions)) {
+            found.push_back(path.string());
+        }
+    }
+    if (error) {
+        cerr << "Error: Directory " << argument << " could not be read: " << error.message() << endl;
+        complete = false;
+    }
+    sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    return complete;
+}
+
+// Function to lex one file, keeping only counts, so neither the cleaned-up
+// text nor the interned token values are built
+FileResult lexFileCounts(const string& path)
+{
+    FileResult result;
+    result.path = path;
+
+    SourceBuffer content;
+    if (!content.open(path))
+        return result;
+    result.opened = true;
+    result.bytes = content.view().length();
+
+    LexicalAnalyzer analyzer(move(content));
+    analyzer.setCollectCleanedInput(false);
+    analyzer.setInternValues(false);
+    Token token(TokenType::UNKNOWN, string_view());
+    while (analyzer.nextToken(token)) {
+        result.countsByType[static_cast<size_t>(token.type)]++;
+        result.tokenCount++;
+    }
+    return result;
+}
+
+// Function to lex many files on a pool of worker threads. Files are
+// scheduled by size with work stealing, and results land at the file's
+// index, so the output order doesn't depend on scheduling.
+vector<FileResult> lexFiles(const vector<string>& files, unsigned threads,
+                            vector<WorkerStats>* workerStats = nullptr)
+{
+    vector<FileResult> results(files.size());
+
+    vector<uint64_t> sizes(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        error_code error;
+        uintmax_t size = filesystem::file_size(files[i], error);
+        sizes[i] = error ? 0 : static_cast<uint64_t>(size);
+    }
+
+    WorkStealingScheduler scheduler;
+    vector<WorkerStats> stats = scheduler.run(sizes, threads, [&](size_t i) {
+        results[i] = lexFileCounts(files[i]);
+    });
+    if (workerStats != nullptr)
+        *workerStats = move(stats);
+    return results;
+}
+
+// Function to get the number of bytes lexed in a multi-file run
+size_t totalBytes(const vector<FileResult>& results)
+{
+    size_t total = 0;
+    for (const FileResult& result : results) {
+        total += result.bytes;
+    }
+    return total;
+}
+
+// Function to add the tokens of each category in a multi-file run to the stats
+void addTokenCounts(const vector<FileResult>& results, RunStats& stats)
+{
+    array<size_t, tokenTypeCount> totalsByType = {};
+    for (const FileResult& result : results) {
+        for (size_t type = 0; type < tokenTypeCount; type++) {
+            totalsByType[type] += result.countsByType[type];
+        }
+    }
+    for (size_t type = 0; type < tokenTypeCount; type++) {
+        stats.count(getTokenTypeName(static_cast<TokenType>(type)), totalsByType[type]);
+    }
+}
+
+// Function to print how busy each worker was
+void printWorkerStats(const vector<WorkerStats>& workerStats, ReportWriter& out)
+{
+    out.left("Worker", 8).right("Files", 10).right("Stolen", 10)
+       .right("Bytes", 14).right("Busy(s)", 10).right("Util", 8) << '\n';
+    out.repeat('-', 60) << '\n';
+    for (size_t i = 0; i < workerStats.size(); i++) {
+        const WorkerStats& worker = workerStats[i];
+        out.left(to_string(i), 8).right(worker.tasks, 10).right(worker.steals, 10)
+           .right(worker.cost, 14).fixed(worker.busySeconds, 3, 10)
+           .fixed(worker.utilization() * 100, 1, 7) << "%\n";
+    }
+}
+
+// Function to print the per-file results and their totals
+void printBatchReport(const vector<FileResult>& results, ReportWriter& out)
+{
+    size_t totalBytes = 0;
+    size_t totalTokens = 0;
+    size_t failed = 0;
+    array<size_t, tokenTypeCount> totalsByType = {};
+
+    out.left("File", 50).right("Bytes", 14).right("Tokens", 12) << '\n';
+    out.repeat('-', 76) << '\n';
+
+    for (const FileResult& result : results) {
+        if (!result.opened) {
+            out.flush();
+            cerr << "Error: File " << result.path << " could not be opened." << endl;
+            failed++;
+            continue;
+        }
+        out.left(result.path, 50).right(result.bytes, 14).right(result.tokenCount, 12) << '\n';
+        totalBytes += result.bytes;
+        totalTokens += result.tokenCount;
+        for (size_t type = 0; type < tokenTypeCount; type++) {
+            totalsByType[type] += result.countsByType[type];
+        }
+    }
+
+    out.repeat('-', 76) << '\n';
+    out.left("Total", 50).right(totalBytes, 14).right(totalTokens, 12) << '\n';
+    if (failed > 0)
+        out << failed << " file(s) could not be opened\n";
+
+    out << '\n';
+    out.left("Category", 15).right("Tokens", 12) << '\n';
+    out.repeat('-', 27) << '\n';
+    for (size_t type = 0; type < tokenTypeCount; type++) {
+        out.left(getTokenTypeName(static_cast<TokenType>(type)), 15).right(totalsByType[type], 12) << '\n';
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "bench_suite.h"
+
+// Benchmark Driver
+//   bench_lexer [--sizes 1K,1M,...] [--max-size 1G] [--min-time seconds]
+//               [--filter case] [--sample file | --corpus seed] [--tmp-dir dir]
+//               [--json file]
+int main(int argc, char* argv[]) {
+
+    BenchOptions options;
+    string samplePath = "input.txt";
+    string jsonPath;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for " << argument << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if (argument == "--sizes") {
+            options.sizes.clear();
+            stringstream list(value);
+            string size;
+            while (getline(list, size, ',')) {
+                options.sizes.push_back(max<size_t>(1, parseByteSize(size)));
+            }
+        }
+        else if (argument == "--max-size") {
+            // Extend or cut the default ladder of sizes, 16x apart
+            size_t maxSize = parseByteSize(value);
+            options.sizes.clear();
+            for (size_t size = 1 << 10; size <= maxSize; size *= 16) {
+                options.sizes.push_back(size);
+            }
+        }
+        else if (argument == "--min-time") {
+            options.minSeconds = atof(value.c_str());
+        }
+        else if (argument == "--filter") {
+            options.filter = value;
+        }
+        else if (argument == "--sample") {
+            samplePath = value;
+        }
+        else if (argument == "--corpus") {
+            options.generated = true;
+            options.corpus.seed = strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (argument == "--tmp-dir") {
+            options.tempDir = value;
+        }
+        else if (argument == "--json") {
+            jsonPath = value;
+        }
+        else {
+            cerr << "Error: Unknown option " << argument << endl;
+            return 2;
+        }
+    }
+
+    SourceBuffer sample;
+    if (!options.generated && (!sample.open(samplePath) || sample.view().empty())) {
+        cerr << "Error: Sample " << samplePath << " could not be opened." << endl;
+        return 1;
+    }
+
+    vector<BenchResult> results = runBenchSuite(sample.view(), options);
+
+    ReportWriter out(fileno(stdout));
+    printBenchResults(results, out);
+
+    if (!jsonPath.empty()) {
+        StringSink json;
+        {
+            ReportWriter jsonOut(json);
+            writeBenchJson(results, jsonOut);
+        }
+        ofstream file(jsonPath, ios::binary);
+        file << json.str();
+        if (!file) {
+            out.flush();
+            cerr << "Error: " << jsonPath << " could not be written." << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
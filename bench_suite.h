@@ -0,0 +1,290 @@
+#ifndef BENCH_SUITE_H
+#define BENCH_SUITE_H
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "alloc_stats.h"
+#include "tokenization.h"
+#include "byte_size.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+
+// Allocations are only counted in builds with -DLEXER_ALLOC_STATS. The
+// counting allocator slows every allocation down, so timings from such a
+// build are not comparable with a normal one; time with one build and
+// count allocations with the other.
+
+// Struct to hold the options of a benchmark run
+struct BenchOptions {
+    vector<size_t> sizes;       // Input sizes in bytes
+    double minSeconds;          // Each case repeats until it has run this long
+    size_t maxIterations;
+    string filter;              // Only run cases whose name contains this
+    string tempDir;             // Where tokenizeFile's input files go
+    bool generated;             // Whether inputs come from the corpus generator
+    CorpusOptions corpus;       // Generator settings; the size is set per input
+
+    BenchOptions()
+        : sizes({ 1 << 10, 16 << 10, 256 << 10, 4 << 20, 64 << 20 })
+        , minSeconds(0.5)
+        , maxIterations(100000)
+        , tempDir("/tmp")
+        , generated(false)
+    {
+    }
+};
+
+// Struct to hold the measurements of one case at one input size
+struct BenchResult {
+    string name;
+    size_t bytes;
+    size_t tokens;              // Tokens handled per iteration
+    size_t iterations;
+    double seconds;             // Median time of one iteration
+    double allocations;         // Allocations per iteration
+    double allocatedBytes;      // Bytes allocated per iteration
+    uint64_t peakLiveBytes;     // Most bytes live at once during any iteration
+
+    BenchResult()
+        : bytes(0)
+        , tokens(0)
+        , iterations(0)
+        , seconds(0)
+        , allocations(0)
+        , allocatedBytes(0)
+        , peakLiveBytes(0)
+    {
+    }
+
+    double megabytesPerSecond() const { return seconds > 0 ? bytes / seconds / 1e6 : 0; }
+    double tokensPerSecond() const { return seconds > 0 ? tokens / seconds : 0; }
+    double nanosecondsPerToken() const { return tokens > 0 ? seconds * 1e9 / tokens : 0; }
+    double allocationsPerToken() const { return tokens > 0 ? allocations / tokens : 0; }
+};
+
+// Function to build a benchmark input of exactly the given size by
+// repeating a sample source, so every run lexes the same text
+string makeBenchInput(string_view sample, size_t size)
+{
+    string text;
+    text.reserve(size);
+    while (text.size() < size) {
+        text.append(sample.substr(0, size - text.size()));
+    }
+    return text;
+}
+
+// Function to time a case: run it once to warm up, then repeat it until
+// it has run for minSeconds, and keep the median iteration. The case
+// returns the number of tokens it handled.
+template <typename Case>
+BenchResult runBenchCase(const string& name, size_t bytes, const BenchOptions& options, Case&& benchCase)
+{
+    BenchResult result;
+    result.name = name;
+    result.bytes = bytes;
+    result.tokens = benchCase();
+
+    vector<double> times;
+    uint64_t allocations = 0;
+    uint64_t bytesAllocated = 0;
+    double total = 0;
+    while (times.empty() || (total < options.minSeconds && times.size() < options.maxIterations)) {
+        resetAllocationPeak();
+        AllocationTotals before = readAllocations();
+        auto start = chrono::steady_clock::now();
+        benchCase();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        AllocationTotals after = readAllocations();
+        allocations += after.count - before.count;
+        bytesAllocated += after.bytes - before.bytes;
+        result.peakLiveBytes = max(result.peakLiveBytes, after.peakLiveBytes - before.liveBytes);
+        times.push_back(seconds);
+        total += seconds;
+    }
+
+    result.iterations = times.size();
+    result.allocations = static_cast<double>(allocations) / times.size();
+    result.allocatedBytes = static_cast<double>(bytesAllocated) / times.size();
+    nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    result.seconds = times[times.size() / 2];
+    return result;
+}
+
+// Class that points standard output at the null device while it exists,
+// so cases that print don't flood the terminal
+class StdoutSilencer {
+private:
+    int saved;
+
+public:
+    StdoutSilencer()
+    {
+        cout.flush();
+#ifdef _WIN32
+        saved = _dup(1);
+        int null = _open("NUL", _O_WRONLY);
+        _dup2(null, 1);
+        _close(null);
+#else
+        saved = dup(1);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, 1);
+        close(null);
+#endif
+    }
+
+    StdoutSilencer(const StdoutSilencer&) = delete;
+    StdoutSilencer& operator=(const StdoutSilencer&) = delete;
+
+    ~StdoutSilencer()
+    {
+        cout.flush();
+#ifdef _WIN32
+        _dup2(saved, 1);
+        _close(saved);
+#else
+        dup2(saved, 1);
+        close(saved);
+#endif
+    }
+};
+
+// Function to run every case whose name matches the filter, at every input size
+vector<BenchResult> runBenchSuite(string_view sample, const BenchOptions& options)
+{
+    vector<BenchResult> results;
+    auto wanted = [&](const string& name) {
+        return options.filter.empty() || name.find(options.filter) != string::npos;
+    };
+
+    for (size_t size : options.sizes) {
+        string input;
+        if (options.generated) {
+            CorpusOptions corpus = options.corpus;
+            corpus.size = size;
+            input = generateCorpus(corpus);
+        }
+        else {
+            input = makeBenchInput(sample, size);
+        }
+
+        // Lexing an in-memory buffer, including the cleaned-up text
+        if (wanted("tokenize")) {
+            results.push_back(runBenchCase("tokenize", size, options, [&]() {
+                LexicalAnalyzer analyzer(SourceBuffer::borrow(input));
+                return analyzer.tokenize().size();
+            }));
+        }
+
+        // Counting, sorting and formatting the unique tokens of lexed input
+        if (wanted("printUniqueTokens")) {
+            LexicalAnalyzer analyzer(SourceBuffer::borrow(input));
+            analyzer.setCollectCleanedInput(false);
+            vector<Token> tokens = analyzer.tokenize();
+            NullSink discard;
+            results.push_back(runBenchCase("printUniqueTokens", size, options, [&]() {
+                ReportWriter out(discard);
+                printUniqueTokens(tokens, out);
+                return tokens.size();
+            }));
+        }
+
+        // Formatting every token through the report writer
+        if (wanted("printTokens")) {
+            LexicalAnalyzer analyzer(SourceBuffer::borrow(input));
+            analyzer.setCollectCleanedInput(false);
+            vector<Token> tokens = analyzer.tokenize();
+            NullSink discard;
+            results.push_back(runBenchCase("printTokens", size, options, [&]() {
+                ReportWriter out(discard);
+                printTokens(tokens, out);
+                return tokens.size();
+            }));
+        }
+
+        // The whole single-file pipeline: read, lex and print the report
+        if (wanted("tokenizeFile")) {
+            string path = options.tempDir + "/bench_lexer_" + formatByteSize(size) + ".txt";
+            {
+                ofstream file(path, ios::binary);
+                file.write(input.data(), static_cast<streamsize>(input.size()));
+            }
+            size_t tokenCount;
+            {
+                LexicalAnalyzer analyzer(SourceBuffer::borrow(input));
+                analyzer.setCollectCleanedInput(false);
+                tokenCount = analyzer.tokenize().size();
+            }
+            {
+                StdoutSilencer silence;
+                results.push_back(runBenchCase("tokenizeFile", size, options, [&]() {
+                    tokenizeFile(path);
+                    return tokenCount;
+                }));
+            }
+            remove(path.c_str());
+        }
+    }
+    return results;
+}
+
+// Function to print the results as a table
+void printBenchResults(const vector<BenchResult>& results, ReportWriter& out)
+{
+    out.left("Case", 20).right("Size", 8).right("Iters", 8).right("MB/s", 10)
+       .right("Mtok/s", 10).right("ns/tok", 9).right("alloc/tok", 11) << '\n';
+    out.repeat('-', 76) << '\n';
+    for (const BenchResult& result : results) {
+        out.left(result.name, 20).right(formatByteSize(result.bytes), 8).right(result.iterations, 8)
+           .fixed(result.megabytesPerSecond(), 1, 10).fixed(result.tokensPerSecond() / 1e6, 2, 10)
+           .fixed(result.nanosecondsPerToken(), 2, 9);
+        if (allocationTracking)
+            out.fixed(result.allocationsPerToken(), 4, 11) << '\n';
+        else
+            out.right("-", 11) << '\n';
+    }
+    if (allocationTracking)
+        out << "\nTimings include the overhead of counting allocations.\n";
+}
+
+// Function to write the results as JSON, one object per case and size
+void writeBenchJson(const vector<BenchResult>& results, ReportWriter& out)
+{
+    out << "{\n  \"benchmark\": \"bench_lexer\",\n  \"allocation_counting\": "
+        << (allocationTracking ? "true" : "false") << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        out << "    { \"name\": \"" << result.name << "\", \"bytes\": " << result.bytes
+            << ", \"tokens\": " << result.tokens << ", \"iterations\": " << result.iterations
+            << ", \"seconds\": ";
+        out.fixed(result.seconds, 9) << ", \"mb_per_s\": ";
+        out.fixed(result.megabytesPerSecond(), 3) << ", \"tokens_per_s\": ";
+        out.fixed(result.tokensPerSecond(), 0) << ", \"ns_per_token\": ";
+        out.fixed(result.nanosecondsPerToken(), 4);
+        if (allocationTracking) {
+            out << ", \"allocs_per_token\": ";
+            out.fixed(result.allocationsPerToken(), 9) << ", \"bytes_allocated_per_token\": ";
+            out.fixed(result.tokens > 0 ? result.allocatedBytes / result.tokens : 0, 4)
+                << ", \"peak_live_bytes\": " << result.peakLiveBytes;
+        }
+        out << " }";
+        out << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+#endif
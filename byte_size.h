@@ -0,0 +1,43 @@
+#ifndef BYTE_SIZE_H
+#define BYTE_SIZE_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+
+// Function to parse a size such as 4096, 16K, 4M or 1G
+size_t parseByteSize(const string& text)
+{
+    char* end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    switch (end != nullptr ? toupper(static_cast<unsigned char>(*end)) : 0) {
+    case 'K':
+        value *= 1 << 10;
+        break;
+    case 'M':
+        value *= 1 << 20;
+        break;
+    case 'G':
+        value *= 1 << 30;
+        break;
+    }
+    return static_cast<size_t>(max(0.0, value));
+}
+
+// Function to format a size as 4096, 16K, 4M or 1G, whichever is exact
+string formatByteSize(size_t bytes)
+{
+    const char* units[] = { "", "K", "M", "G" };
+    size_t unit = 0;
+    while (unit < 3 && bytes >= 1024 && bytes % 1024 == 0) {
+        bytes /= 1024;
+        unit++;
+    }
+    return to_string(bytes) + units[unit];
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef CHAR_CLASSES_H
+#define CHAR_CLASSES_H
+
+#include <array>
+#include <cstdint>
+
+using namespace std;
+
+
+// Bit flags describing what a byte can be part of
+enum CharClass : uint8_t {
+    CHAR_SPACE = 1,     // ' ', '\t', '\n', '\r'
+    CHAR_ALPHA = 2,     // 'a'-'z', 'A'-'Z'
+    CHAR_DIGIT = 4,     // '0'-'9'
+    CHAR_WORD = 8       // Letters, digits and '_'
+};
+
+// Kind of token that starts with a byte, used to dispatch on the first
+// byte of each token with a single switch
+enum class CharDispatch : uint8_t {
+    OTHER,
+    WHITESPACE,
+    WORD,
+    DIGIT,
+    SLASH,
+    HASH,
+    QUOTE,
+    ANGLE,
+    OPERATOR,
+    SEPARATOR
+};
+
+// Function to build the 256-entry table of character class flags
+constexpr array<uint8_t, 256> buildCharClasses()
+{
+    array<uint8_t, 256> table = {};
+    table[' '] = table['\t'] = table['\n'] = table['\r'] = CHAR_SPACE;
+    for (int c = 'a'; c <= 'z'; c++) {
+        table[c] = CHAR_ALPHA | CHAR_WORD;
+        table[c - 'a' + 'A'] = CHAR_ALPHA | CHAR_WORD;
+    }
+    for (int c = '0'; c <= '9'; c++) {
+        table[c] = CHAR_DIGIT | CHAR_WORD;
+    }
+    table['_'] = CHAR_WORD;
+    return table;
+}
+
+// Function to build the 256-entry first-byte dispatch table
+constexpr array<CharDispatch, 256> buildCharDispatch()
+{
+    array<CharDispatch, 256> table = {};
+    table[' '] = table['\t'] = table['\n'] = table['\r'] = CharDispatch::WHITESPACE;
+    for (int c = 'a'; c <= 'z'; c++) {
+        table[c] = CharDispatch::WORD;
+        table[c - 'a' + 'A'] = CharDispatch::WORD;
+    }
+    table['_'] = CharDispatch::WORD;
+    for (int c = '0'; c <= '9'; c++) {
+        table[c] = CharDispatch::DIGIT;
+    }
+    table['/'] = CharDispatch::SLASH;
+    table['#'] = CharDispatch::HASH;
+    table['"'] = CharDispatch::QUOTE;
+    table['<'] = table['>'] = CharDispatch::ANGLE;
+    for (char c : { '+', '-', '*', '=', '^' }) {
+        table[static_cast<unsigned char>(c)] = CharDispatch::OPERATOR;
+    }
+    for (char c : { '(', ')', '{', '}', ',', ';' }) {
+        table[static_cast<unsigned char>(c)] = CharDispatch::SEPARATOR;
+    }
+    return table;
+}
+
+constexpr array<uint8_t, 256> charClasses = buildCharClasses();
+constexpr array<CharDispatch, 256> charDispatch = buildCharDispatch();
+
+// Function to check a byte against a set of CharClass flags
+inline bool hasCharClass(char c, uint8_t flags)
+{
+    return (charClasses[static_cast<unsigned char>(c)] & flags) != 0;
+}
+
+#endif
@@ -0,0 +1,339 @@
+#ifndef CORPUS_GENERATOR_H
+#define CORPUS_GENERATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "keywords.h"
+
+using namespace std;
+
+
+// Lines every generated corpus starts with
+constexpr string_view corpusHeader = "#include <iostream>\nusing namespace std;\n\n";
+
+// Struct to hold the knobs of a generated corpus. Densities are shares
+// between 0 and 1.
+struct CorpusOptions {
+    uint64_t seed;
+    size_t size;                // Exact size of the output in bytes
+    double commentDensity;      // Share of the output bytes inside comments
+    double blockCommentShare;   // Share of comments written as /* */ blocks
+    double literalDensity;      // Share of operands that are literals
+    double stringShare;         // Share of literals that are string literals
+    double escapeRate;          // Chance that a string literal character is escaped
+    size_t identifierMin;       // Identifier lengths: at least min, at most max,
+    size_t identifierMax;       // geometrically distributed around mean
+    double identifierMean;
+    size_t vocabulary;          // Number of distinct identifiers to draw from
+
+    CorpusOptions()
+        : seed(1)
+        , size(1 << 20)
+        , commentDensity(0.2)
+        , blockCommentShare(0.3)
+        , literalDensity(0.3)
+        , stringShare(0.4)
+        , escapeRate(0.02)
+        , identifierMin(1)
+        , identifierMax(32)
+        , identifierMean(8)
+        , vocabulary(2000)
+    {
+    }
+};
+
+// Class that generates C++-like source text shaped like what the lexical
+// analyzer handles: keywords, identifiers, numbers, string literals with
+// escapes, << and >>, and line and block comments. The output depends
+// only on the options, on every platform, since the generator uses its
+// own random number generator and distributions.
+class CorpusGenerator {
+private:
+    CorpusOptions options;
+    uint64_t state;
+    vector<string> identifiers;
+    size_t commentBytes;
+    size_t totalBytes;
+
+    // Function to get the next random 64-bit number (SplitMix64)
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Function to get a random number in [0, bound)
+    size_t below(size_t bound) { return bound > 0 ? static_cast<size_t>(next() % bound) : 0; }
+
+    // Function to get a random number in [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Function to return true with a given probability
+    bool chance(double probability) { return uniform() < probability; }
+
+    // Function to pick one of a list of strings
+    template <size_t N>
+    string_view pick(const string_view (&choices)[N]) { return choices[below(N)]; }
+
+    // Function to draw an identifier length: min plus a geometric number
+    // of extra characters, so the mean comes out near identifierMean
+    size_t identifierLength()
+    {
+        double extra = max(0.0, options.identifierMean - static_cast<double>(options.identifierMin));
+        size_t length = options.identifierMin;
+        double stop = 1.0 / (extra + 1.0);
+        while (length < options.identifierMax && !chance(stop)) {
+            length++;
+        }
+        return max<size_t>(1, length);
+    }
+
+    // Function to build the vocabulary of distinct, non-keyword identifiers
+    void buildVocabulary()
+    {
+        static const char first[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+        static const char rest[] = "abcdefghijklmnopqrstuvwxyz_0123456789";
+        identifiers.clear();
+        size_t attempts = 0;
+        while (identifiers.size() < max<size_t>(1, options.vocabulary) && attempts++ < options.vocabulary * 20 + 100) {
+            string name(1, first[below(sizeof(first) - 1)]);
+            for (size_t length = identifierLength(); name.size() < length;) {
+                name += rest[below(sizeof(rest) - 1)];
+            }
+            if (!isKeyword(name))
+                identifiers.push_back(name);
+        }
+        sort(identifiers.begin(), identifiers.end());
+        identifiers.erase(unique(identifiers.begin(), identifiers.end()), identifiers.end());
+        if (identifiers.empty())
+            identifiers.push_back("x");
+        // Shuffle so popularity doesn't follow alphabetical order
+        for (size_t i = identifiers.size(); i > 1; i--) {
+            swap(identifiers[i - 1], identifiers[below(i)]);
+        }
+    }
+
+    // Function to pick an identifier, favoring the start of the
+    // vocabulary the way real code reuses a few names heavily
+    string_view identifier()
+    {
+        double u = uniform();
+        return identifiers[min(identifiers.size() - 1, static_cast<size_t>(identifiers.size() * u * u * u))];
+    }
+
+    // Function to write a numeric literal
+    void number(string& out)
+    {
+        out += to_string(below(chance(0.7) ? 100 : 1000000));
+        if (chance(0.2)) {
+            out += '.';
+            out += to_string(below(1000));
+        }
+    }
+
+    // Function to write a string literal, escaping some characters
+    void stringLiteral(string& out)
+    {
+        static const char text[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJ0123456789:,.!?-=+";
+        static const char escapes[] = "nt\\\"0";
+        out += '"';
+        for (size_t length = below(24); length > 0; length--) {
+            if (chance(options.escapeRate)) {
+                out += '\\';
+                out += escapes[below(sizeof(escapes) - 1)];
+            }
+            else {
+                out += text[below(sizeof(text) - 1)];
+            }
+        }
+        out += '"';
+    }
+
+    // Function to write an operand: an identifier or a literal
+    void operand(string& out)
+    {
+        if (!chance(options.literalDensity))
+            out += identifier();
+        else if (chance(options.stringShare))
+            stringLiteral(out);
+        else
+            number(out);
+    }
+
+    // Function to write an expression of operands joined by operators
+    void expression(string& out)
+    {
+        static const string_view operators[] = { " + ", " - ", " * ", " / ", " % ", " < ", " > ", " == ", " != ",
+                                                 "+", "-", "*" };
+        operand(out);
+        for (size_t terms = below(4); terms > 0; terms--) {
+            out += pick(operators);
+            operand(out);
+        }
+    }
+
+    // Function to write a line comment or a block comment of a few lines
+    void comment(string& out, const string& indent)
+    {
+        static const string_view words[] = { "the", "sum", "of", "value", "check", "input", "result", "loop",
+                                             "TODO", "count", "index", "when", "is", "not", "*", "/", "//", "\"" };
+        size_t start = out.size();
+        bool block = chance(options.blockCommentShare);
+        out += indent;
+        out += block ? "/*" : "//";
+        for (size_t count = 3 + below(10); count > 0; count--) {
+            out += ' ';
+            string_view word = pick(words);
+            // A block comment can't contain its own terminator
+            if (block && (word == "/" || word == "//"))
+                word = "or";
+            out += word;
+            if (block && chance(0.15)) {
+                out += '\n';
+                out += indent;
+                out += " *";
+            }
+        }
+        out += block ? " */\n" : "\n";
+        commentBytes += out.size() - start;
+    }
+
+    // Function to write one statement line at the given nesting depth
+    void statement(string& out, size_t& depth)
+    {
+        static const string_view types[] = { "int", "float", "string", "void", "int", "float" };
+        out += string(depth * 4, ' ');
+
+        // Close blocks more eagerly the deeper they nest
+        if (depth > 0 && chance(0.1 + 0.05 * depth)) {
+            out.resize(out.size() - 4);
+            out += "}\n";
+            depth--;
+            return;
+        }
+
+        switch (below(depth > 0 ? 8 : 7)) {
+        case 0:
+        case 1:
+            out += pick(types);
+            out += ' ';
+            out += identifier();
+            out += " = ";
+            expression(out);
+            out += ";\n";
+            break;
+        case 2:
+            out += "cout << ";
+            operand(out);
+            for (size_t terms = below(3); terms > 0; terms--) {
+                out += " << ";
+                operand(out);
+            }
+            out += " << endl;\n";
+            break;
+        case 3:
+            out += "cin >> ";
+            out += identifier();
+            out += ";\n";
+            break;
+        case 4:
+            out += identifier();
+            out += '(';
+            for (size_t arguments = below(4); arguments > 0; arguments--) {
+                operand(out);
+                if (arguments > 1)
+                    out += ", ";
+            }
+            out += ");\n";
+            break;
+        case 5:
+            out += chance(0.5) ? "if (" : "while (";
+            expression(out);
+            out += ") {\n";
+            depth++;
+            break;
+        case 6:
+            out += pick(types);
+            out += ' ';
+            out += identifier();
+            out += "(int ";
+            out += identifier();
+            out += ", float ";
+            out += identifier();
+            out += ") {\n";
+            depth++;
+            break;
+        default:
+            out += "return ";
+            expression(out);
+            out += ";\n";
+            break;
+        }
+    }
+
+public:
+
+    explicit CorpusGenerator(const CorpusOptions& options)
+        : options(options)
+        , state(options.seed)
+        , commentBytes(0)
+        , totalBytes(0)
+    {
+        buildVocabulary();
+    }
+
+    // Function to generate a corpus of exactly options.size bytes. Lines
+    // that would run past the end are replaced by newline padding, so the
+    // text never ends inside a token or comment. A size too small for the
+    // header gives only newlines.
+    string generate()
+    {
+        string out;
+        out.reserve(options.size);
+        commentBytes = 0;
+        totalBytes = 0;
+        if (options.size < corpusHeader.size()) {
+            out.assign(options.size, '\n');
+            return out;
+        }
+        out += corpusHeader;
+        size_t depth = 0;
+        string line;
+        while (true) {
+            line.clear();
+            totalBytes = out.size();
+            if (totalBytes > 0 && static_cast<double>(commentBytes) < options.commentDensity * totalBytes)
+                comment(line, string(depth * 4, ' '));
+            else
+                statement(line, depth);
+            if (out.size() + line.size() > options.size)
+                break;
+            out += line;
+        }
+        out.resize(min(out.size(), options.size));
+        out.resize(options.size, '\n');
+        return out;
+    }
+
+    // Function to get the share of the last corpus that is comments
+    double commentShare() const { return totalBytes > 0 ? static_cast<double>(commentBytes) / totalBytes : 0; }
+
+    // Function to get the distinct identifiers the corpus draws from
+    const vector<string>& vocabularyWords() const { return identifiers; }
+};
+
+// Function to generate a corpus with the given options
+string generateCorpus(const CorpusOptions& options)
+{
+    CorpusGenerator generator(options);
+    return generator.generate();
+}
+
+#endif
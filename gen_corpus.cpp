@@ -0,0 +1,74 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "corpus_generator.h"
+#include "byte_size.h"
+#include "report_writer.h"
+
+// Corpus Generator Driver
+//   gen_corpus [--seed n] [--size 64M] [--comments 0.2] [--block-comments 0.3]
+//              [--literals 0.3] [--strings 0.4] [--escapes 0.02]
+//              [--ident-min 1] [--ident-mean 8] [--ident-max 32] [--vocabulary 2000]
+//              [-o file]
+int main(int argc, char* argv[]) {
+
+    CorpusOptions options;
+    string outputPath;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for " << argument << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if (argument == "--seed")
+            options.seed = strtoull(value.c_str(), nullptr, 10);
+        else if (argument == "--size")
+            options.size = parseByteSize(value);
+        else if (argument == "--comments")
+            options.commentDensity = atof(value.c_str());
+        else if (argument == "--block-comments")
+            options.blockCommentShare = atof(value.c_str());
+        else if (argument == "--literals")
+            options.literalDensity = atof(value.c_str());
+        else if (argument == "--strings")
+            options.stringShare = atof(value.c_str());
+        else if (argument == "--escapes")
+            options.escapeRate = atof(value.c_str());
+        else if (argument == "--ident-min")
+            options.identifierMin = strtoul(value.c_str(), nullptr, 10);
+        else if (argument == "--ident-mean")
+            options.identifierMean = atof(value.c_str());
+        else if (argument == "--ident-max")
+            options.identifierMax = strtoul(value.c_str(), nullptr, 10);
+        else if (argument == "--vocabulary")
+            options.vocabulary = strtoul(value.c_str(), nullptr, 10);
+        else if (argument == "-o")
+            outputPath = value;
+        else {
+            cerr << "Error: Unknown option " << argument << endl;
+            return 2;
+        }
+    }
+
+    if (options.size < corpusHeader.size()) {
+        cerr << "Error: --size must be at least " << corpusHeader.size() << " bytes." << endl;
+        return 2;
+    }
+
+    string corpus = generateCorpus(options);
+
+    if (outputPath.empty()) {
+        ReportWriter out(fileno(stdout));
+        out << corpus;
+        return 0;
+    }
+    ofstream file(outputPath, ios::binary);
+    file.write(corpus.data(), static_cast<streamsize>(corpus.size()));
+    if (!file) {
+        cerr << "Error: " << outputPath << " could not be written." << endl;
+        return 1;
+    }
+    return 0;
+}
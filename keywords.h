@@ -0,0 +1,117 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+using namespace std;
+
+
+// Keywords recognized by the lexical analyzer. To add one, append it here;
+// the perfect hash below is regenerated at compile time, and the build
+// fails with a static_assert if no collision-free seed can be found.
+constexpr string_view keywordList[] = {
+    "int",
+    "float",
+    "if",
+    "else",
+    "while",
+    "return",
+    "string",
+    "do",
+    "void",
+    "cout",
+    "endl",
+    "for",
+    "#include",
+    "using",
+    "namespace",
+    "std",
+    "iostream",
+    "fstream",
+    "vector",
+};
+
+constexpr size_t keywordCount = sizeof(keywordList) / sizeof(keywordList[0]);
+
+// Number of slots in the hash table (a power of two, at least keywordCount)
+constexpr unsigned keywordTableBits = 6;
+constexpr size_t keywordTableSize = size_t(1) << keywordTableBits;
+
+// Function to get the length of the longest keyword
+constexpr size_t findMaxKeywordLength()
+{
+    size_t longest = 0;
+    for (string_view keyword : keywordList) {
+        if (keyword.size() > longest)
+            longest = keyword.size();
+    }
+    return longest;
+}
+
+constexpr size_t maxKeywordLength = findMaxKeywordLength();
+
+// Function to hash a word from its length and its first, middle and last
+// characters, so a lookup touches at most three bytes of the word
+constexpr uint32_t keywordHash(const char* word, size_t length, uint32_t seed)
+{
+    uint32_t h = (static_cast<uint32_t>(length) ^ seed) * 0x9E3779B1u;
+    h = (h ^ static_cast<unsigned char>(word[0])) * 0x85EBCA6Bu;
+    h = (h ^ static_cast<unsigned char>(word[length / 2])) * 0xC2B2AE35u;
+    h = (h ^ static_cast<unsigned char>(word[length - 1])) * 0x27D4EB2Fu;
+    return h >> (32 - keywordTableBits);
+}
+
+// Function to search for a seed that gives every keyword its own slot
+constexpr uint32_t findKeywordSeed()
+{
+    for (uint32_t seed = 0; seed < 100000; seed++) {
+        bool used[keywordTableSize] = {};
+        bool collision = false;
+        for (string_view keyword : keywordList) {
+            uint32_t slot = keywordHash(keyword.data(), keyword.size(), seed);
+            if (used[slot]) {
+                collision = true;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (!collision)
+            return seed;
+    }
+    return UINT32_MAX;
+}
+
+constexpr uint32_t keywordSeed = findKeywordSeed();
+static_assert(keywordSeed != UINT32_MAX,
+              "No perfect hash for keywordList; increase keywordTableBits");
+
+// Function to build the slot table (keyword index + 1, or 0 for an empty slot)
+constexpr array<uint8_t, keywordTableSize> buildKeywordSlots()
+{
+    array<uint8_t, keywordTableSize> slots = {};
+    for (size_t i = 0; i < keywordCount; i++) {
+        slots[keywordHash(keywordList[i].data(), keywordList[i].size(), keywordSeed)]
+            = static_cast<uint8_t>(i + 1);
+    }
+    return slots;
+}
+
+constexpr array<uint8_t, keywordTableSize> keywordSlots = buildKeywordSlots();
+
+// Function to check if a word is a keyword
+inline bool isKeyword(string_view word)
+{
+    if (word.empty() || word.size() > maxKeywordLength)
+        return false;
+    uint8_t slot = keywordSlots[keywordHash(word.data(), word.size(), keywordSeed)];
+    if (slot == 0)
+        return false;
+    string_view keyword = keywordList[slot - 1];
+    return keyword.size() == word.size()
+           && memcmp(keyword.data(), word.data(), word.size()) == 0;
+}
+
+#endif
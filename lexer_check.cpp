@@ -0,0 +1,605 @@
+#include "tokenization.h"
+#include "parallel_lexer.h"
+#include "token_stream.h"
+#include "token_generator.h"
+#include "corpus_generator.h"
+
+#include <map>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Class that draws random numbers for the checks (SplitMix64)
+class CheckRandom {
+private:
+    uint64_t state;
+
+public:
+    explicit CheckRandom(uint64_t seed)
+        : state(seed)
+    {
+    }
+
+    // Function to get the next random 64-bit number
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Function to get a random number in [0, bound)
+    size_t below(size_t bound) { return bound > 0 ? static_cast<size_t>(next() % bound) : 0; }
+};
+
+// Function to build a random input. Half are generated corpora; the rest
+// are a soup of the fragments the lexer treats specially, so comment,
+// string and operator boundaries land everywhere, chunk cuts included.
+string makeCheckInput(CheckRandom& random)
+{
+    if (random.below(2) == 0) {
+        CorpusOptions options;
+        options.seed = random.next();
+        options.size = 64 + random.below(8192);
+        options.commentDensity = random.below(60) / 100.0;
+        options.escapeRate = random.below(30) / 100.0;
+        return generateCorpus(options);
+    }
+
+    static const string_view fragments[] = {
+        "/*", "*/", "//", "/", "*", "\"", "\\", "\\\"", "\n", "\r\n", " ", "\t", "#", "#include", "<", "<<",
+        ">", ">>", "a", "int", "while", "x_1", "_", "12", "3.45", ".", "=", "+", "^", "(", ")", "{", "}",
+        ",", ";", "@", "\x80", "\xff"
+    };
+    string text;
+    for (size_t count = random.below(600); count > 0; count--) {
+        text += fragments[random.below(sizeof(fragments) / sizeof(fragments[0]))];
+    }
+    return text;
+}
+
+// Function to describe a token for a mismatch report
+string describeToken(const Token& token)
+{
+    return string(getTokenTypeName(token.type)) + " '" + token.str() + "'";
+}
+
+// Function to check that lexing a buffer in parallel chunks gives the same
+// tokens, cleaned-up text and interned values as lexing it in one pass
+bool checkParallel(uint64_t seed, size_t iterations)
+{
+    CheckRandom random(seed);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        string text = makeCheckInput(random);
+        unsigned threads = static_cast<unsigned>(1 + random.below(8));
+        size_t minChunkSize = 1 + random.below(512);
+
+        LexicalAnalyzer serial(SourceBuffer::borrow(text));
+        vector<Token> expected = serial.tokenize();
+        unique_ptr<ParallelTokenization> parallel = tokenizeParallel(SourceBuffer::borrow(text), threads, minChunkSize);
+
+        string problem;
+        if (parallel->tokens.size() != expected.size())
+            problem = to_string(parallel->tokens.size()) + " tokens instead of " + to_string(expected.size());
+        for (size_t i = 0; problem.empty() && i < expected.size(); i++) {
+            const Token& token = parallel->tokens[i];
+            if (token.type != expected[i].type || token.value != expected[i].value)
+                problem = "token " + to_string(i) + " is " + describeToken(token) + " instead of " + describeToken(expected[i]);
+            else if (parallel->symbols.lookup(token.id) != token.value)
+                problem = "token " + to_string(i) + " has the ID of '" + string(parallel->symbols.lookup(token.id)) + "'";
+        }
+        if (problem.empty() && parallel->cleanedInput != serial.cleanedText())
+            problem = "the cleaned-up text differs";
+
+        if (!problem.empty()) {
+            cerr << "parallel: input " << iteration << " (" << text.size() << " bytes, " << threads
+                 << " threads, chunks of " << minChunkSize << "): " << problem << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to compare lexed tokens with the expected ones, returning a
+// description of the first difference, or an empty string if there is none
+string compareTokens(const vector<pair<TokenType, string>>& tokens, const vector<Token>& expected)
+{
+    for (size_t i = 0; i < min(tokens.size(), expected.size()); i++) {
+        if (tokens[i].first != expected[i].type || tokens[i].second != expected[i].value)
+            return "token " + to_string(i) + " is " + string(getTokenTypeName(tokens[i].first)) + " '"
+                + tokens[i].second + "' instead of " + describeToken(expected[i]);
+    }
+    if (tokens.size() != expected.size())
+        return to_string(tokens.size()) + " tokens instead of " + to_string(expected.size());
+    return string();
+}
+
+// Function to check that lexing a stream chunk by chunk gives the same
+// tokens and cleaned-up text as lexing the whole buffer. Half the inputs go
+// through tokenizeStream() with a fixed chunk size, often just a few bytes,
+// and half through feed() with chunks of random sizes, empty ones included.
+bool checkStream(uint64_t seed, size_t iterations)
+{
+    CheckRandom random(seed);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        string text = makeCheckInput(random);
+        LexicalAnalyzer whole(SourceBuffer::borrow(text));
+        vector<Token> expected = whole.tokenize();
+
+        vector<pair<TokenType, string>> tokens;
+        auto consumer = [&](const Token& token) { tokens.emplace_back(token.type, token.str()); };
+        StringSink cleaned;
+        bool fixedChunks = random.below(2) == 0;
+        size_t chunkSize = 1 + random.below(random.below(3) == 0 ? text.size() + 1 : 8);
+        if (fixedChunks) {
+            istringstream in(text);
+            tokenizeStream(in, consumer, chunkSize, &cleaned);
+        }
+        else {
+            LexicalAnalyzer streamed;
+            streamed.setCleanedSink(&cleaned);
+            for (size_t offset = 0; offset < text.size();) {
+                size_t length = min(text.size() - offset, random.below(2 * chunkSize + 1));
+                streamed.feed(string_view(text).substr(offset, length), consumer);
+                offset += length;
+            }
+            streamed.finish(consumer);
+        }
+
+        string problem = compareTokens(tokens, expected);
+        if (problem.empty() && cleaned.str() != whole.cleanedText())
+            problem = "the cleaned-up text differs";
+        if (!problem.empty()) {
+            cerr << "stream: input " << iteration << " (" << text.size() << " bytes, "
+                 << (fixedChunks ? "chunks of " : "chunks of up to ")
+                 << (fixedChunks ? chunkSize : 2 * chunkSize) << "): " << problem << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to check that a columnar token stream holds the same tokens as
+// tokenize(), row by row, that its per-type counts and visits agree, and
+// that it prints the same unique tokens
+bool checkColumns(uint64_t seed, size_t iterations)
+{
+    CheckRandom random(seed);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        string text = makeCheckInput(random);
+        LexicalAnalyzer rows(SourceBuffer::borrow(text));
+        vector<Token> expected = rows.tokenize();
+        LexicalAnalyzer columns(SourceBuffer::borrow(text));
+        TokenStream stream;
+        tokenizeToStream(columns, stream);
+
+        string problem;
+        if (stream.size() != expected.size())
+            problem = to_string(stream.size()) + " tokens instead of " + to_string(expected.size());
+        for (size_t i = 0; problem.empty() && i < expected.size(); i++) {
+            Token token = stream[i];
+            if (token.type != expected[i].type || token.value != expected[i].value || stream.type(i) != token.type
+                || stream.value(i) != token.value)
+                problem = "row " + to_string(i) + " is " + describeToken(token) + " instead of " + describeToken(expected[i]);
+            else if (stream.id(i) != expected[i].id || columns.symbols().lookup(stream.id(i)) != token.value)
+                problem = "row " + to_string(i) + " has the ID of '" + string(columns.symbols().lookup(stream.id(i))) + "'";
+        }
+        for (size_t type = 0; problem.empty() && type < tokenTypeCount; type++) {
+            vector<size_t> visited;
+            stream.forEachOfType(static_cast<TokenType>(type), [&](size_t index) { visited.push_back(index); });
+            vector<size_t> wanted;
+            for (size_t i = 0; i < expected.size(); i++) {
+                if (static_cast<size_t>(expected[i].type) == type)
+                    wanted.push_back(i);
+            }
+            if (stream.count(static_cast<TokenType>(type)) != wanted.size() || visited != wanted)
+                problem = "the " + string(getTokenTypeName(static_cast<TokenType>(type))) + " tokens are counted as "
+                    + to_string(stream.count(static_cast<TokenType>(type))) + " instead of " + to_string(wanted.size());
+        }
+        if (problem.empty()) {
+            StringSink fromRows;
+            StringSink fromColumns;
+            {
+                ReportWriter rowsOut(fromRows);
+                printUniqueTokens(expected, rowsOut);
+                ReportWriter columnsOut(fromColumns);
+                printUniqueTokens(stream, columnsOut);
+            }
+            if (fromRows.str() != fromColumns.str())
+                problem = "the unique tokens printed differ";
+        }
+
+        if (!problem.empty()) {
+            cerr << "columns: input " << iteration << " (" << text.size() << " bytes): " << problem << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+// Function to check that the coroutine generator yields the same tokens as
+// tokenize(), and that stopping it early leaves the analyzer right after
+// the last token it yielded
+bool checkGenerator(uint64_t seed, size_t iterations)
+{
+    CheckRandom random(seed);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        string text = makeCheckInput(random);
+        LexicalAnalyzer whole(SourceBuffer::borrow(text));
+        vector<Token> expected = whole.tokenize();
+
+        LexicalAnalyzer analyzer(SourceBuffer::borrow(text));
+        size_t stopAfter = random.below(2) == 0 ? expected.size() : 1 + random.below(expected.size());
+        vector<pair<TokenType, string>> tokens;
+        {
+            TokenGenerator generator = generateTokens(analyzer);
+            for (const Token& token : generator) {
+                tokens.emplace_back(token.type, token.str());
+                if (tokens.size() == stopAfter)
+                    break;
+            }
+        }
+        for (const Token& token : analyzer.tokenize()) {
+            tokens.emplace_back(token.type, token.str());
+        }
+
+        string problem = compareTokens(tokens, expected);
+        if (problem.empty() && analyzer.cleanedText() != whole.cleanedText())
+            problem = "the cleaned-up text differs";
+        if (!problem.empty()) {
+            cerr << "generator: input " << iteration << " (" << text.size() << " bytes, stopped after " << stopAfter
+                 << " tokens): " << problem << endl;
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+// Function to check that every set of vector scanning kernels finds the
+// same run ends as the scalar kernels. Buffers are allocated at their
+// exact size, so a sanitizer build also catches reads past the end.
+bool checkKernels(uint64_t seed, size_t iterations)
+{
+    static const char alphabet[] = "  \t\n\r\r\n____aZz09099/**/*//x.\"\\#<\x80\xff";
+    const vector<const ScanKernels*>& available = availableScanKernels();
+    const ScanKernels& scalar = *available.front();
+    CheckRandom random(seed);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        // Long runs of one class, broken up now and then
+        size_t length = random.below(300);
+        unique_ptr<char[]> buffer(new char[max<size_t>(1, length)]);
+        char c = alphabet[random.below(sizeof(alphabet) - 1)];
+        for (size_t i = 0; i < length; i++) {
+            if (random.below(12) == 0)
+                c = alphabet[random.below(sizeof(alphabet) - 1)];
+            buffer[i] = random.below(20) == 0 ? alphabet[random.below(sizeof(alphabet) - 1)] : c;
+        }
+        const char* end = buffer.get() + length;
+        const char* p = buffer.get() + random.below(length + 1);
+
+        for (const ScanKernels* kernels : available) {
+            const char* name = nullptr;
+            if (kernels->skipWhitespace(p, end) != scalar.skipWhitespace(p, end))
+                name = "skipWhitespace";
+            else if (kernels->skipWordChars(p, end) != scalar.skipWordChars(p, end))
+                name = "skipWordChars";
+            else if (kernels->skipDigits(p, end) != scalar.skipDigits(p, end))
+                name = "skipDigits";
+            else if (kernels->findCommentEnd(p, end) != scalar.findCommentEnd(p, end))
+                name = "findCommentEnd";
+            if (name != nullptr) {
+                cerr << "kernels: " << kernels->name << ' ' << name << " differs from scalar on input "
+                     << iteration << " at offset " << (p - buffer.get()) << " of " << length << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Function to build the cleaned-up text the simple way, byte by byte:
+// comments and whitespace are dropped, string literals are written with
+// their escapes decoded and closed if the input ends inside one, and
+// every other byte is kept
+string referenceCleanedText(string_view text)
+{
+    string cleaned;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '/' && i + 1 < text.size() && text[i + 1] == '*') {
+            size_t close = text.find("*/", i + 2);
+            i = close == string_view::npos ? text.size() : close + 2;
+        }
+        else if (c == '/' && i + 1 < text.size() && text[i + 1] == '/') {
+            size_t newline = text.find('\n', i + 2);
+            i = newline == string_view::npos ? text.size() : newline;
+        }
+        else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            i++;
+        }
+        else if (c == '"') {
+            cleaned += '"';
+            for (i++; i < text.size() && text[i] != '"'; i++) {
+                if (text[i] == '\\' && ++i >= text.size())
+                    break;
+                cleaned += text[i];
+            }
+            cleaned += '"';
+            i++;
+        }
+        else {
+            cleaned += c;
+            i++;
+        }
+    }
+    return cleaned;
+}
+
+// Function to check that the cleaned-up text assembled from source spans
+// matches the byte-by-byte version, both in memory and through a file
+// descriptor sink with a small buffer, so large spans take the writev path
+bool checkCleanedText(uint64_t seed, size_t iterations)
+{
+    CheckRandom random(seed);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        string text = makeCheckInput(random);
+        string expected = referenceCleanedText(text);
+
+        LexicalAnalyzer inMemory(SourceBuffer::borrow(text));
+        inMemory.tokenize();
+        const char* problem = nullptr;
+        if (inMemory.cleanedText() != expected)
+            problem = "in memory";
+
+        FILE* file = tmpfile();
+        if (problem == nullptr && file != nullptr) {
+            {
+                FdSink sink(fileno(file), 1 + random.below(64));
+                LexicalAnalyzer streamed(SourceBuffer::borrow(text));
+                streamed.setCleanedSink(&sink);
+                streamed.tokenize();
+                streamed.setCleanedSink(nullptr);
+            }
+            string written(expected.size() + 1, '\0');
+            rewind(file);
+            written.resize(fread(&written[0], 1, written.size(), file));
+            if (written != expected)
+                problem = "through an FdSink";
+        }
+        if (file != nullptr)
+            fclose(file);
+
+        if (problem != nullptr) {
+            cerr << "cleaned: input " << iteration << " (" << text.size() << " bytes): the cleaned-up text "
+                 << problem << " differs from the byte-by-byte version" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to check the character class and dispatch tables against the
+// comparisons they replaced, for every byte
+bool checkCharTables()
+{
+    for (int byte = 0; byte < 256; byte++) {
+        char c = static_cast<char>(byte);
+        bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        bool digit = c >= '0' && c <= '9';
+        bool word = alpha || digit || c == '_';
+        if (hasCharClass(c, CHAR_SPACE) != space || hasCharClass(c, CHAR_ALPHA) != alpha
+            || hasCharClass(c, CHAR_DIGIT) != digit || hasCharClass(c, CHAR_WORD) != word) {
+            cerr << "tables: wrong class flags for byte " << byte << endl;
+            return false;
+        }
+
+        CharDispatch expected = CharDispatch::OTHER;
+        if (space)
+            expected = CharDispatch::WHITESPACE;
+        else if (alpha || c == '_')
+            expected = CharDispatch::WORD;
+        else if (digit)
+            expected = CharDispatch::DIGIT;
+        else if (c == '/')
+            expected = CharDispatch::SLASH;
+        else if (c == '#')
+            expected = CharDispatch::HASH;
+        else if (c == '"')
+            expected = CharDispatch::QUOTE;
+        else if (c == '<' || c == '>')
+            expected = CharDispatch::ANGLE;
+        else if (strchr("+-*=^", c) != nullptr && c != '\0')
+            expected = CharDispatch::OPERATOR;
+        else if (strchr("(){},;", c) != nullptr && c != '\0')
+            expected = CharDispatch::SEPARATOR;
+        if (charDispatch[static_cast<unsigned char>(c)] != expected) {
+            cerr << "tables: wrong dispatch for byte " << byte << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to check that inputs ending in any byte that makes the lexer
+// look ahead are lexed without reading past the end. Where memory
+// protection is available the input ends right before an unreadable page,
+// so a stray read crashes instead of passing silently.
+bool checkInputEnd()
+{
+    static const string_view endings[] = { "/", "#", "<", ">", "\"", "\"a\\", "a", "1", "1.", "*", "/*", "/**", "//" };
+#ifndef _WIN32
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    char* map = static_cast<char*>(mmap(nullptr, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (map == MAP_FAILED)
+        return false;
+    mprotect(map + page, page, PROT_NONE);
+#endif
+    for (string_view ending : endings) {
+        for (size_t length = ending.size(); length <= ending.size() + 40; length += 20) {
+#ifndef _WIN32
+            char* text = map + page - length;
+#else
+            unique_ptr<char[]> buffer(new char[length]);
+            char* text = buffer.get();
+#endif
+            memset(text, ' ', length - ending.size());
+            memcpy(text + length - ending.size(), ending.data(), ending.size());
+            LexicalAnalyzer analyzer(SourceBuffer::borrow(string_view(text, length)));
+            analyzer.tokenize();
+            if (analyzer.cleanedText() != referenceCleanedText(string_view(text, length))) {
+                cerr << "input end: wrong cleaned-up text for an input ending in '" << ending << "'" << endl;
+                return false;
+            }
+        }
+    }
+#ifndef _WIN32
+    munmap(map, 2 * page);
+#endif
+    return true;
+}
+
+// Function to check that the radix sort of distinct values matches a
+// comparison sort. Besides random sets, it sorts values that share prefixes
+// thousands of bytes long, which once overflowed the stack.
+bool checkSortedValues(uint64_t seed, size_t iterations)
+{
+    CheckRandom random(seed);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        string prefix(iteration % 4 == 0 ? 4000 + random.below(4000) : random.below(4), 'p');
+        vector<string> values;
+        for (size_t count = random.below(iteration % 4 == 0 ? 200 : 2000); count > 0; count--) {
+            string value = prefix;
+            for (size_t length = random.below(6); length > 0; length--) {
+                value += "ab\x80\xff"[random.below(4)];
+            }
+            values.push_back(value);
+        }
+
+        ValueCounter counter;
+        map<string, uint64_t> expected;
+        for (const string& value : values) {
+            counter.add(value);
+            expected[value]++;
+        }
+        vector<ValueCounter::Entry> sorted = counter.sorted();
+        bool same = sorted.size() == expected.size();
+        auto next = expected.begin();
+        for (size_t i = 0; same && i < sorted.size(); i++, next++) {
+            same = sorted[i].value == next->first && sorted[i].count == next->second;
+        }
+        if (!same) {
+            cerr << "sorted: set " << iteration << " (" << values.size() << " values, prefix of " << prefix.size()
+                 << " bytes) is out of order" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to check that an analyzer reused with reset() gives the same
+// tokens and cleaned-up text as a fresh one, also after it has streamed,
+// and, in builds with LEXER_ALLOC_STATS, that once it has seen every
+// snippet, going over them again doesn't allocate at all
+bool checkReset(uint64_t seed, size_t iterations)
+{
+    CheckRandom random(seed);
+    vector<string> snippets(64);
+    for (string& snippet : snippets) {
+        snippet = makeCheckInput(random);
+    }
+
+    LexicalAnalyzer reused;
+    reused.feed(snippets[0], [](const Token&) {});
+    reused.finish([](const Token&) {});
+    vector<Token> tokens;
+    for (size_t i = 0; i < snippets.size(); i++) {
+        reused.reset(snippets[i]);
+        reused.tokenize(tokens);
+        LexicalAnalyzer fresh(SourceBuffer::borrow(snippets[i]));
+        vector<Token> expected = fresh.tokenize();
+        bool same = tokens.size() == expected.size();
+        for (size_t j = 0; same && j < tokens.size(); j++) {
+            same = tokens[j].type == expected[j].type && tokens[j].value == expected[j].value;
+        }
+        if (!same || reused.cleanedText() != fresh.cleanedText()) {
+            cerr << "reset: snippet " << i << " (" << snippets[i].size() << " bytes): the "
+                 << (same ? "cleaned-up text differs" : "tokens differ") << " from a fresh analyzer's" << endl;
+            return false;
+        }
+    }
+
+    if (allocationTracking) {
+        uint64_t before = readAllocations().count;
+        for (size_t i = 0; i < iterations; i++) {
+            reused.reset(snippets[i % snippets.size()]);
+            reused.tokenize(tokens);
+            reused.cleanedText();
+        }
+        uint64_t allocations = readAllocations().count - before;
+        if (allocations != 0) {
+            cerr << "reset: " << allocations << " allocations over " << iterations << " resets after warming up" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to run a check and print its outcome. Returns true if it passed.
+template <typename Check>
+bool runCheck(const char* name, Check&& check)
+{
+    bool passed = check();
+    cout << name << ": " << (passed ? "ok" : "FAILED") << endl;
+    return passed;
+}
+
+// Lexer Self-Check
+//   lexer_check [--iterations n] [--seed n]
+// Compares the lexer's fast paths against simpler ways of getting the
+// same answer, on random inputs. Exits with 1 if any check fails.
+int main(int argc, char* argv[]) {
+
+    size_t iterations = 2000;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for " << argument << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if (argument == "--iterations") {
+            iterations = strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (argument == "--seed") {
+            seed = strtoull(value.c_str(), nullptr, 10);
+        }
+        else {
+            cerr << "Error: Unknown option " << argument << endl;
+            return 2;
+        }
+    }
+
+    bool passed = true;
+    passed = runCheck("parallel", [&]() { return checkParallel(seed, iterations); }) && passed;
+    passed = runCheck("stream", [&]() { return checkStream(seed, iterations); }) && passed;
+    passed = runCheck("cleaned", [&]() { return checkCleanedText(seed, iterations); }) && passed;
+    passed = runCheck("columns", [&]() { return checkColumns(seed, iterations); }) && passed;
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+    passed = runCheck("generator", [&]() { return checkGenerator(seed, iterations); }) && passed;
+#endif
+    passed = runCheck("kernels", [&]() { return checkKernels(seed, iterations * 50); }) && passed;
+    passed = runCheck("sorted", [&]() { return checkSortedValues(seed, iterations / 10); }) && passed;
+    passed = runCheck("tables", [&]() { return checkCharTables(); }) && passed;
+    passed = runCheck("input end", [&]() { return checkInputEnd(); }) && passed;
+    passed = runCheck("reset", [&]() { return checkReset(seed, iterations * 50); }) && passed;
+    return passed ? 0 : 1;
+}
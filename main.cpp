@@ -6,14 +6,120 @@
  ********************************/
 
 #include "tokenization.h"
+#include "batch.h"
+#include "parallel_lexer.h"
 
 // Driver Code
-int main() {
-    
-    tokenizeFile("input.txt");
+int main(int argc, char* argv[]) {
 
-    cin.clear();
-    cin.ignore(256, '\n');
+    //   out.exe [--stats] [--stats-json file] [--perf] [-j threads] [--ext .cpp,.h] paths...
+    //   out.exe [--stats] [-j threads] --split files...
+    BatchOptions options;
+    vector<string> arguments;
+    bool showStats = false;
+    bool countEvents = false;
+    bool split = false;
+    string statsJsonPath;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "-j" && i + 1 < argc) {
+            options.threads = static_cast<unsigned>(max(1, atoi(argv[++i])));
+        }
+        else if (argument == "--ext" && i + 1 < argc) {
+            options.extensions.clear();
+            stringstream list(argv[++i]);
+            string extension;
+            while (getline(list, extension, ',')) {
+                options.extensions.push_back(extension);
+            }
+        }
+        else if (argument == "--stats") {
+            showStats = true;
+        }
+        else if (argument == "--split") {
+            split = true;
+        }
+        else if (argument == "--perf") {
+            showStats = true;
+            countEvents = true;
+        }
+        else if (argument == "--stats-json" && i + 1 < argc) {
+            showStats = true;
+            statsJsonPath = argv[++i];
+        }
+        else {
+            arguments.push_back(argument);
+        }
+    }
 
-    return 0;
+    RunStats runStats;
+    RunStats* stats = showStats ? &runStats : nullptr;
+    if (countEvents)
+        runStats.enableCounters();
+
+    // With no paths, lex the sample file
+    if (arguments.empty()) {
+        tokenizeFile("input.txt", stats);
+        if (stats)
+            reportRunStats(*stats, statsJsonPath);
+
+        if (argc < 2) {
+            cin.clear();
+            cin.ignore(256, '\n');
+        }
+
+        return 0;
+    }
+
+    // Lex each file on its own, split into chunks lexed on all threads
+    if (split) {
+        bool allOpened = true;
+        for (const string& argument : arguments) {
+            allOpened = tokenizeFileParallel(argument, options.threads, stats) && allOpened;
+        }
+        if (stats)
+            reportRunStats(*stats, statsJsonPath);
+        return allOpened ? 0 : 1;
+    }
+
+    // Otherwise lex the given files, directories and @manifests
+    if (stats)
+        stats->start("find");
+    vector<string> files;
+    bool complete = true;
+    for (const string& argument : arguments) {
+        complete = addBatchPath(argument, options, files) && complete;
+    }
+    if (stats)
+        stats->stop();
+
+    vector<WorkerStats> workerStats;
+    if (stats)
+        stats->start("lex");
+    vector<FileResult> results = lexFiles(files, options.threads, &workerStats);
+    if (stats)
+        stats->stop(totalBytes(results));
+
+    if (stats)
+        stats->start("print");
+    {
+        ReportWriter out(fileno(stdout));
+        printBatchReport(results, out);
+    }
+    if (stats) {
+        stats->stop();
+        addTokenCounts(results, *stats);
+
+        // Worker timings change from run to run, so they stay off stdout
+        {
+            ReportWriter err(fileno(stderr));
+            err << '\n';
+            printWorkerStats(workerStats, err);
+        }
+        reportRunStats(*stats, statsJsonPath);
+    }
+
+    // Fail if any path couldn't be read, after reporting what could
+    bool allOpened = all_of(results.begin(), results.end(), [](const FileResult& result) { return result.opened; });
+    return complete && allOpened ? 0 : 1;
 }
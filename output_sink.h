@@ -0,0 +1,163 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+
+// Interface for a destination of text, such as the cleaned-up output of
+// the lexical analyzer
+class OutputSink {
+public:
+    virtual ~OutputSink() {}
+
+    // Function to add bytes to the output
+    virtual void write(const char* data, size_t length) = 0;
+
+    // Function to push out anything still buffered
+    virtual void flush() {}
+
+    void write(string_view text) { write(text.data(), text.size()); }
+    void put(char c) { write(&c, 1); }
+};
+
+// Sink that throws everything away
+class NullSink : public OutputSink {
+public:
+    void write(const char*, size_t) override {}
+};
+
+// Sink that keeps everything in a memory buffer
+class StringSink : public OutputSink {
+private:
+    string text;
+
+public:
+    void write(const char* data, size_t length) override { text.append(data, length); }
+
+    // Function to get the text written so far
+    const string& str() const { return text; }
+
+    // Function to empty the buffer, keeping its capacity
+    void clear() { text.clear(); }
+
+    // Function to make room for at least a number of bytes
+    void reserve(size_t size) { text.reserve(size); }
+};
+
+// Sink that collects writes in a large buffer and hands them to a file
+// descriptor in blocks. Writes bigger than the buffer bypass it.
+class FdSink : public OutputSink {
+private:
+    int fd;
+    vector<char> buffer;
+    size_t used;
+    bool failed;
+
+    // Function to write bytes straight to the descriptor
+    void writeAll(const char* data, size_t length)
+    {
+        while (length > 0 && !failed) {
+#ifdef _WIN32
+            int count = _write(fd, data, static_cast<unsigned>(min<size_t>(length, 1u << 30)));
+#else
+            ssize_t count = ::write(fd, data, length);
+            if (count < 0 && errno == EINTR)
+                continue;
+#endif
+            if (count <= 0) {
+                failed = true;
+                return;
+            }
+            data += count;
+            length -= static_cast<size_t>(count);
+        }
+    }
+
+    // Function to write the buffered bytes and then a large block that
+    // isn't in the buffer, with one writev() call when possible
+    void writeBufferedThen(const char* data, size_t length)
+    {
+#ifndef _WIN32
+        while (used > 0 && !failed) {
+            iovec pieces[2] = { { buffer.data(), used }, { const_cast<char*>(data), length } };
+            ssize_t count = ::writev(fd, pieces, 2);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0) {
+                failed = true;
+                return;
+            }
+            size_t written = static_cast<size_t>(count);
+            if (written < used) {
+                memmove(buffer.data(), buffer.data() + written, used - written);
+                used -= written;
+                continue;
+            }
+            written -= used;
+            used = 0;
+            data += written;
+            length -= written;
+        }
+#else
+        flush();
+#endif
+        writeAll(data, length);
+    }
+
+public:
+
+    explicit FdSink(int fd, size_t bufferSize = 1 << 20)
+        : fd(fd)
+        , buffer(bufferSize)
+        , used(0)
+        , failed(false)
+    {
+    }
+
+    FdSink(const FdSink&) = delete;
+    FdSink& operator=(const FdSink&) = delete;
+
+    ~FdSink() override { flush(); }
+
+    void write(const char* data, size_t length) override
+    {
+        if (length <= buffer.size() - used) {
+            memcpy(buffer.data() + used, data, length);
+            used += length;
+            return;
+        }
+        if (length >= buffer.size()) {
+            writeBufferedThen(data, length);
+            return;
+        }
+        flush();
+        memcpy(buffer.data(), data, length);
+        used = length;
+    }
+
+    void flush() override
+    {
+        writeAll(buffer.data(), used);
+        used = 0;
+    }
+
+    // Function to check if a write to the descriptor has failed
+    bool bad() const { return failed; }
+};
+
+#endif
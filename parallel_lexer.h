@@ -0,0 +1,220 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include <memory>
+
+#include "tokenization.h"
+#include "work_stealing.h"
+
+using namespace std;
+
+
+// Guess about the lexer state at the start of a chunk
+enum class ChunkGuess {
+    NORMAL,
+    BLOCK_COMMENT,
+    STRING_LITERAL
+};
+
+// Struct to hold what was lexed from one chunk of a buffer
+struct ChunkResult {
+    size_t begin;           // Offset where the chunk starts
+    size_t end;             // Offset where the next chunk starts
+    ChunkGuess guess;
+    size_t start;           // Offset of the first token, given the guess
+    size_t exit;            // Offset of the first token after the chunk
+    unique_ptr<LexicalAnalyzer> analyzer;
+    vector<Token> tokens;
+};
+
+// Class that holds the result of lexing one buffer in parallel. It owns
+// the source and the per-chunk analyzers the tokens point into.
+class ParallelTokenization {
+public:
+    SourceBuffer source;
+    vector<ChunkResult> chunks;
+    vector<Token> tokens;
+    string cleanedInput;
+    StringInterner symbols;     // Token IDs are remapped into this table
+    size_t relexedChunks;
+
+    ParallelTokenization()
+        : relexedChunks(0)
+    {
+    }
+};
+
+// Function to guess the lexer state at a line start. If the next "*/"
+// within a few KB comes before any "/*", the line is probably inside a
+// block comment. Otherwise, an odd number of unescaped quotes on the line
+// means it is probably inside a string literal.
+ChunkGuess guessChunkState(string_view text, size_t begin)
+{
+    string_view ahead = text.substr(begin, 4096);
+    size_t closeComment = ahead.find("*/");
+    if (closeComment != string_view::npos && ahead.substr(0, closeComment + 1).find("/*") == string_view::npos)
+        return ChunkGuess::BLOCK_COMMENT;
+
+    size_t quotes = 0;
+    for (size_t i = 0; i < ahead.length() && ahead[i] != '\n'; i++) {
+        if (ahead[i] == '\\')
+            i++;
+        else if (ahead[i] == '"')
+            quotes++;
+    }
+    return quotes % 2 == 1 ? ChunkGuess::STRING_LITERAL : ChunkGuess::NORMAL;
+}
+
+// Function to find where a chunk's first token starts under its guess
+size_t findGuessedStart(LexicalAnalyzer& analyzer, string_view text, const ChunkResult& chunk)
+{
+    size_t offset = chunk.begin;
+    if (chunk.guess == ChunkGuess::STRING_LITERAL) {
+        // Move past the quote that closes the string
+        while (offset < text.length() && text[offset] != '"') {
+            offset += text[offset] == '\\' ? 2 : 1;
+        }
+        offset = min(offset + 1, text.length());
+    }
+    analyzer.seek(offset, chunk.guess == ChunkGuess::BLOCK_COMMENT, chunk.end);
+    return analyzer.skipToNextToken();
+}
+
+// Function to lex a chunk from its start offset, in the normal state
+void lexChunk(string_view text, ChunkResult& chunk, size_t from)
+{
+    chunk.analyzer = make_unique<LexicalAnalyzer>(SourceBuffer::borrow(text));
+    chunk.analyzer->seek(from, false, chunk.end);
+    chunk.start = chunk.analyzer->skipToNextToken();
+    chunk.tokens.clear();
+    Token token(TokenType::UNKNOWN, string_view());
+    while (chunk.analyzer->nextToken(token)) {
+        chunk.tokens.push_back(token);
+    }
+    chunk.exit = chunk.analyzer->tell();
+}
+
+// Function to lex one buffer on several threads. The buffer is cut at line
+// starts into chunks that are lexed in parallel from a guessed starting
+// state. The chunks are then checked in order: when a chunk's first token
+// is not where the previous chunk actually stopped, only that chunk is
+// lexed again. The tokens and cleaned-up text match sequential lexing.
+unique_ptr<ParallelTokenization> tokenizeParallel(SourceBuffer&& source, unsigned threads,
+                                                  size_t minChunkSize = 1 << 20)
+{
+    auto result = make_unique<ParallelTokenization>();
+    result->source = move(source);
+    string_view text = result->source.view();
+
+    // Cut the buffer just after a newline near each even split point
+    size_t chunkCount = max<size_t>(1, min<size_t>(max(1u, threads) * 4, text.length() / max<size_t>(1, minChunkSize)));
+    vector<size_t> cuts = { 0 };
+    for (size_t i = 1; i < chunkCount; i++) {
+        size_t newline = text.find('\n', text.length() / chunkCount * i);
+        if (newline == string_view::npos)
+            break;
+        if (newline + 1 > cuts.back() && newline + 1 < text.length())
+            cuts.push_back(newline + 1);
+    }
+    cuts.push_back(text.length());
+
+    result->chunks.resize(cuts.size() - 1);
+    for (size_t i = 0; i + 1 < cuts.size(); i++) {
+        ChunkResult& chunk = result->chunks[i];
+        chunk.begin = cuts[i];
+        chunk.end = i + 2 < cuts.size() ? cuts[i + 1] : string_view::npos;
+        chunk.guess = i == 0 ? ChunkGuess::NORMAL : guessChunkState(text, chunk.begin);
+    }
+
+    // Lex every chunk speculatively
+    vector<uint64_t> costs(result->chunks.size(), 1);
+    WorkStealingScheduler scheduler;
+    scheduler.run(costs, threads, [&](size_t i) {
+        ChunkResult& chunk = result->chunks[i];
+        LexicalAnalyzer probe(SourceBuffer::borrow(text));
+        lexChunk(text, chunk, findGuessedStart(probe, text, chunk));
+    });
+
+    // Stitch the chunks, relexing any whose guess was wrong
+    size_t actual = result->chunks.empty() ? 0 : result->chunks[0].exit;
+    for (size_t i = 1; i < result->chunks.size(); i++) {
+        ChunkResult& chunk = result->chunks[i];
+        if (chunk.start != actual) {
+            lexChunk(text, chunk, actual);
+            result->relexedChunks++;
+        }
+        actual = chunk.exit;
+    }
+
+    // Merge the tokens, cleaned-up text and interned IDs
+    size_t tokenCount = 0;
+    size_t cleanedLength = 0;
+    for (const ChunkResult& chunk : result->chunks) {
+        tokenCount += chunk.tokens.size();
+        cleanedLength += chunk.analyzer->cleanedText().length();
+    }
+    result->tokens.reserve(tokenCount);
+    result->cleanedInput.reserve(cleanedLength);
+    for (const ChunkResult& chunk : result->chunks) {
+        vector<uint32_t> remap = result->symbols.merge(chunk.analyzer->symbols());
+        for (Token token : chunk.tokens) {
+            token.id = remap[token.id];
+            result->tokens.push_back(token);
+        }
+        result->cleanedInput += chunk.analyzer->cleanedText();
+    }
+    return result;
+}
+
+// Function to read a file and lex it on several threads, printing the same
+// report as tokenizeFile(). Returns false if the file can't be opened.
+bool tokenizeFileParallel(const string& filename, unsigned threads, RunStats* stats = nullptr)
+{
+    if (stats)
+        stats->start("read");
+    SourceBuffer fileContent;
+    if (!fileContent.open(filename)) {
+        cerr << "Error: File " << filename << " could not be opened." << endl;
+        if (stats)
+            stats->stop();
+        return false;
+    }
+    size_t bytes = fileContent.view().length();
+    if (stats)
+        stats->stop(bytes);
+
+    if (stats)
+        stats->start("lex");
+    unique_ptr<ParallelTokenization> lexed = tokenizeParallel(move(fileContent), threads);
+    if (stats)
+        stats->stop(bytes);
+
+    if (stats)
+        stats->start("aggregate");
+    array<ValueCounter, tokenTypeCount> tokenCategories = countUniqueTokens(lexed->tokens);
+    if (stats)
+        stats->stop();
+
+    if (stats)
+        stats->start("print");
+    ReportWriter out(fileno(stdout));
+    out << "Cleaned-up Input:\n" << lexed->cleanedInput << "\n\n";
+    out << '\n';
+    printTokenCategories(tokenCategories, out);
+    out << '\n';
+    out.flush();
+    if (stats) {
+        stats->stop();
+        array<uint64_t, tokenTypeCount> countsByType = {};
+        for (const Token& token : lexed->tokens) {
+            countsByType[static_cast<size_t>(token.type)]++;
+        }
+        for (size_t type = 0; type < tokenTypeCount; type++) {
+            stats->count(getTokenTypeName(static_cast<TokenType>(type)), countsByType[type]);
+        }
+        stats->count("relexed chunks", lexed->relexedChunks);
+    }
+    return true;
+}
+
+#endif
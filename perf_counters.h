@@ -0,0 +1,226 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+
+// Hardware events counted around each phase
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCHES,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    perfEventCount
+};
+
+// Function to get the name of a hardware event
+string_view getPerfEventName(size_t event)
+{
+    static const string_view names[perfEventCount] = {
+        "cycles", "instructions", "branches", "branch-misses", "L1d-misses", "LLC-misses"
+    };
+    return event < perfEventCount ? names[event] : "unknown";
+}
+
+// Struct to hold the counts of one measurement. Events the CPU or kernel
+// could not count are marked invalid.
+struct PerfReading {
+    array<uint64_t, perfEventCount> values;
+    array<bool, perfEventCount> valid;
+
+    PerfReading()
+        : values()
+        , valid()
+    {
+    }
+
+    // Function to get the ratio of two events, or a negative number if either is missing
+    double ratio(PerfEvent numerator, PerfEvent denominator) const
+    {
+        if (!valid[numerator] || !valid[denominator] || values[denominator] == 0)
+            return -1;
+        return static_cast<double>(values[numerator]) / values[denominator];
+    }
+};
+
+// Class that counts hardware events for the calling thread with a
+// perf_event_open() group, so every event covers exactly the same span
+// of execution. Events the machine lacks are left out of the group; if
+// even the cycle counter can't be opened, as is common in containers and
+// under a strict perf_event_paranoid, the group reports why and every
+// reading comes back empty.
+class PerfCounterGroup {
+private:
+    array<int, perfEventCount> fds;
+    array<uint64_t, perfEventCount> ids;
+    string error;
+
+#ifdef __linux__
+    // Function to open one event, in the group led by leader (or as the leader if -1)
+    static int openEvent(size_t event, int leader)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        auto cacheMiss = [](uint64_t cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        switch (event) {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_BRANCHES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_INSTRUCTIONS;
+            break;
+        case PERF_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cacheMiss(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cacheMiss(PERF_COUNT_HW_CACHE_LL);
+            break;
+        }
+        attr.disabled = leader == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                           | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+    }
+#endif
+
+public:
+
+    PerfCounterGroup()
+        : ids()
+    {
+        fds.fill(-1);
+    }
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    ~PerfCounterGroup() { close(); }
+
+    // Function to open the counters. Returns false, with a reason in
+    // unavailableReason(), if hardware counters can't be used here.
+    bool open()
+    {
+        close();
+#ifdef __linux__
+        fds[PERF_CYCLES] = openEvent(PERF_CYCLES, -1);
+        if (fds[PERF_CYCLES] < 0) {
+            error = string("perf_event_open failed: ") + strerror(errno);
+            if (errno == EACCES || errno == EPERM)
+                error += " (check /proc/sys/kernel/perf_event_paranoid)";
+            return false;
+        }
+        for (size_t event = PERF_CYCLES + 1; event < perfEventCount; event++) {
+            fds[event] = openEvent(event, fds[PERF_CYCLES]);
+        }
+        for (size_t event = 0; event < perfEventCount; event++) {
+            if (fds[event] >= 0 && ioctl(fds[event], PERF_EVENT_IOC_ID, &ids[event]) != 0) {
+                ::close(fds[event]);
+                fds[event] = -1;
+            }
+        }
+        error.clear();
+        return true;
+#else
+        error = "hardware counters are only supported on Linux";
+        return false;
+#endif
+    }
+
+    // Function to close the counters
+    void close()
+    {
+#ifdef __linux__
+        for (int& fd : fds) {
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    // Function to check if the counters are open
+    bool available() const { return fds[PERF_CYCLES] >= 0; }
+
+    // Function to get why the counters could not be opened
+    const string& unavailableReason() const { return error; }
+
+    // Function to zero the counters and start counting
+    void start()
+    {
+#ifdef __linux__
+        if (!available())
+            return;
+        ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Function to stop counting and read the counts. Counts are scaled up
+    // if the kernel had to multiplex the group with other users.
+    PerfReading stop()
+    {
+        PerfReading reading;
+#ifdef __linux__
+        if (!available())
+            return reading;
+        ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, time enabled, time running, then a value and ID per event
+        uint64_t data[3 + 2 * perfEventCount];
+        ssize_t length = ::read(fds[PERF_CYCLES], data, sizeof(data));
+        if (length < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+            return reading;
+        uint64_t count = min<uint64_t>(data[0], perfEventCount);
+        double scale = data[2] > 0 && data[2] < data[1] ? static_cast<double>(data[1]) / data[2] : 1.0;
+        if (data[2] == 0)
+            return reading;
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t value = data[3 + 2 * i];
+            uint64_t id = data[4 + 2 * i];
+            for (size_t event = 0; event < perfEventCount; event++) {
+                if (fds[event] >= 0 && ids[event] == id) {
+                    reading.values[event] = static_cast<uint64_t>(value * scale);
+                    reading.valid[event] = true;
+                }
+            }
+        }
+#endif
+        return reading;
+    }
+};
+
+#endif
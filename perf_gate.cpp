@@ -0,0 +1,194 @@
+#include "perf_gate.h"
+
+// Performance Regression Gate
+//   perf_gate [--baseline file] [--update] [--repeat n] [--tolerance share]
+//             [--alloc-tolerance share] [--noise errors] [--sizes 16K,4M,...]
+//             [--min-time seconds] [--filter case] [--sample file | --corpus seed]
+//             [--tmp-dir dir] [--json file]
+// A normal build checks MB/s and ns/token; a build with -DLEXER_ALLOC_STATS
+// checks allocations/token against its own baseline.
+// Exits with 1 if any metric regressed, 2 if the gate couldn't run or a
+// case it ran has no baseline entry.
+int main(int argc, char* argv[]) {
+
+    GateOptions options;
+    string baselinePath = allocationTracking ? "bench_alloc_baseline.json" : "bench_baseline.json";
+    string samplePath;
+    string jsonPath;
+    bool update = false;
+    bool sizesGiven = false;
+    bool corpusGiven = false;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "--update") {
+            update = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for " << argument << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if (argument == "--baseline") {
+            baselinePath = value;
+        }
+        else if (argument == "--repeat") {
+            options.repetitions = max<size_t>(1, strtoull(value.c_str(), nullptr, 10));
+        }
+        else if (argument == "--tolerance") {
+            options.tolerance = atof(value.c_str());
+        }
+        else if (argument == "--alloc-tolerance") {
+            options.allocationTolerance = atof(value.c_str());
+        }
+        else if (argument == "--noise") {
+            options.noise = atof(value.c_str());
+        }
+        else if (argument == "--sizes") {
+            options.bench.sizes.clear();
+            stringstream list(value);
+            string size;
+            while (getline(list, size, ',')) {
+                options.bench.sizes.push_back(max<size_t>(1, parseByteSize(size)));
+            }
+            sizesGiven = true;
+        }
+        else if (argument == "--min-time") {
+            options.bench.minSeconds = atof(value.c_str());
+        }
+        else if (argument == "--filter") {
+            options.bench.filter = value;
+        }
+        else if (argument == "--sample") {
+            samplePath = value;
+            options.bench.generated = false;
+        }
+        else if (argument == "--corpus") {
+            options.bench.generated = true;
+            options.bench.corpus.seed = strtoull(value.c_str(), nullptr, 10);
+            corpusGiven = true;
+        }
+        else if (argument == "--tmp-dir") {
+            options.bench.tempDir = value;
+        }
+        else if (argument == "--json") {
+            jsonPath = value;
+        }
+        else {
+            cerr << "Error: Unknown option " << argument << endl;
+            return 2;
+        }
+    }
+
+    // Unless told otherwise, measure the sizes and corpus the baseline has
+    vector<GateEntry> baseline;
+    if (!update) {
+        SourceBuffer file;
+        if (!file.open(baselinePath)) {
+            cerr << "Error: Baseline " << baselinePath << " could not be opened. Use --update to create it." << endl;
+            return 2;
+        }
+        GateJsonReader reader(file.view());
+        uint64_t corpusSeed = 0;
+        bool hasCorpusSeed = false;
+        if (!reader.read(baseline, corpusSeed, hasCorpusSeed)) {
+            cerr << "Error: Baseline " << baselinePath << ": " << reader.errorMessage() << endl;
+            return 2;
+        }
+        if (hasCorpusSeed && !corpusGiven && options.bench.generated)
+            options.bench.corpus.seed = corpusSeed;
+        if (!sizesGiven && !baseline.empty()) {
+            options.bench.sizes.clear();
+            for (const GateEntry& entry : baseline) {
+                if (find(options.bench.sizes.begin(), options.bench.sizes.end(), entry.bytes) == options.bench.sizes.end())
+                    options.bench.sizes.push_back(entry.bytes);
+            }
+        }
+    }
+
+    SourceBuffer sample;
+    if (!options.bench.generated && (!sample.open(samplePath) || sample.view().empty())) {
+        cerr << "Error: Sample " << samplePath << " could not be opened." << endl;
+        return 2;
+    }
+
+    vector<GateEntry> current = measureGate(sample.view(), options);
+    for (GateEntry& entry : current) {
+        entry.gated = !gateEntryNoisy(entry, options);
+    }
+
+    auto writeJson = [&](const string& path) {
+        StringSink json;
+        {
+            ReportWriter jsonOut(json);
+            writeGateJson(current, options, jsonOut);
+        }
+        ofstream file(path, ios::binary);
+        file << json.str();
+        return static_cast<bool>(file);
+    };
+
+    if (!jsonPath.empty() && !writeJson(jsonPath)) {
+        cerr << "Error: " << jsonPath << " could not be written." << endl;
+        return 2;
+    }
+
+    ReportWriter out(fileno(stdout));
+    if (update) {
+        // Entries too noisy to gate on are kept but marked
+        for (const GateEntry& entry : current) {
+            if (!entry.gated)
+                out << "Too noisy to gate: " << entry.name << ' ' << formatByteSize(entry.bytes) << '\n';
+        }
+        if (none_of(current.begin(), current.end(), [](const GateEntry& entry) { return entry.gated; })) {
+            out.flush();
+            cerr << "Error: Every entry was too noisy. Try a higher --min-time or --repeat." << endl;
+            return 2;
+        }
+        if (!writeJson(baselinePath)) {
+            out.flush();
+            cerr << "Error: " << baselinePath << " could not be written." << endl;
+            return 2;
+        }
+        out << "Wrote " << current.size() << " baseline entries to " << baselinePath << '\n';
+        return 0;
+    }
+
+    size_t compared;
+    size_t regressions = compareGate(baseline, current, options, out, compared);
+    for (const GateEntry& entry : baseline) {
+        bool measured = any_of(current.begin(), current.end(), [&](const GateEntry& candidate) {
+            return candidate.name == entry.name && candidate.bytes == entry.bytes;
+        });
+        if (!measured)
+            out << "Not measured: " << entry.name << ' ' << formatByteSize(entry.bytes) << '\n';
+    }
+
+    out << '\n' << regressions << " regression" << (regressions == 1 ? "" : "s") << " ("
+        << options.repetitions << " repetitions, tolerance ";
+    out.fixed(options.tolerance * 100, 1) << "%, allocations ";
+    out.fixed(options.allocationTolerance * 100, 1) << "%, noise ";
+    out.fixed(options.noise, 1) << " standard errors)\n";
+    if (compared == 0) {
+        out.flush();
+        cerr << "Error: Nothing in " << baselinePath << " could be compared with this build's measurements." << endl;
+        return 2;
+    }
+
+    // A case run without a baseline entry could regress unnoticed
+    size_t unbaselined = 0;
+    for (const GateEntry& entry : current) {
+        bool found = any_of(baseline.begin(), baseline.end(), [&](const GateEntry& candidate) {
+            return candidate.name == entry.name && candidate.bytes == entry.bytes;
+        });
+        if (!found) {
+            out.flush();
+            cerr << "Error: " << entry.name << ' ' << formatByteSize(entry.bytes) << " has no entry in " << baselinePath
+                 << ". Rerun with --update." << endl;
+            unbaselined++;
+        }
+    }
+    if (unbaselined > 0)
+        return 2;
+    return regressions > 0 ? 1 : 0;
+}
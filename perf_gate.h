@@ -0,0 +1,469 @@
+#ifndef PERF_GATE_H
+#define PERF_GATE_H
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench_suite.h"
+
+using namespace std;
+
+
+// Struct to hold the median and median absolute deviation of one metric
+// over the repetitions of a gate run
+struct GateMetric {
+    double median;
+    double mad;
+    size_t samples;             // Repetitions the median was taken over
+    bool measured;              // False if the build or baseline doesn't have this metric
+
+    GateMetric()
+        : median(0)
+        , mad(0)
+        , samples(1)
+        , measured(false)
+    {
+    }
+};
+
+// Struct to hold the metrics of one case at one input size
+struct GateEntry {
+    string name;
+    size_t bytes;
+    GateMetric megabytesPerSecond;
+    GateMetric nanosecondsPerToken;
+    GateMetric allocationsPerToken;
+    bool gated;                 // False if the run was too noisy to gate on
+
+    GateEntry()
+        : bytes(0)
+        , gated(true)
+    {
+    }
+};
+
+// Struct to hold the options of a gate run
+struct GateOptions {
+    BenchOptions bench;         // Cases, sizes and corpus to run
+    size_t repetitions;         // Times the whole suite is run
+    double tolerance;           // Allowed slowdown in MB/s and ns/token, as a share
+    double allocationTolerance; // Allowed growth in allocations/token, as a share
+    double noise;               // Changes within this many standard errors are noise
+
+    GateOptions()
+        : repetitions(9)
+        , tolerance(0.10)
+        , allocationTolerance(0.05)
+        , noise(3)
+    {
+        bench.sizes = { 16 << 10, 256 << 10, 4 << 20 };
+        bench.minSeconds = 0.5;
+        bench.generated = true;
+    }
+};
+
+// Function to get the median of some values
+double medianOf(vector<double> values)
+{
+    if (values.empty())
+        return 0;
+    size_t middle = values.size() / 2;
+    nth_element(values.begin(), values.begin() + middle, values.end());
+    double median = values[middle];
+    if (values.size() % 2 == 0)
+        median = (median + *max_element(values.begin(), values.begin() + middle)) / 2;
+    return median;
+}
+
+// Function to get the median and median absolute deviation of some values
+GateMetric summarize(const vector<double>& values, bool measured)
+{
+    GateMetric metric;
+    metric.measured = measured;
+    if (!measured)
+        return metric;
+    metric.samples = max<size_t>(1, values.size());
+    metric.median = medianOf(values);
+    vector<double> deviations;
+    deviations.reserve(values.size());
+    for (double value : values) {
+        deviations.push_back(fabs(value - metric.median));
+    }
+    metric.mad = medianOf(deviations);
+    return metric;
+}
+
+// Function to run the benchmark suite the given number of times and
+// summarize each case and size over the repetitions. Whole suites are
+// repeated, rather than each case in a row, so drift in the machine's
+// speed is spread over every case. A normal build measures time, and a
+// build with LEXER_ALLOC_STATS measures allocations only, since its
+// counting allocator would skew the timings.
+vector<GateEntry> measureGate(string_view sample, const GateOptions& options)
+{
+    vector<GateEntry> entries;
+    vector<array<vector<double>, 3>> samples;
+    for (size_t repetition = 0; repetition < max<size_t>(1, options.repetitions); repetition++) {
+        vector<BenchResult> results = runBenchSuite(sample, options.bench);
+        for (size_t i = 0; i < results.size(); i++) {
+            if (repetition == 0) {
+                entries.emplace_back();
+                entries.back().name = results[i].name;
+                entries.back().bytes = results[i].bytes;
+                samples.emplace_back();
+            }
+            samples[i][0].push_back(results[i].megabytesPerSecond());
+            samples[i][1].push_back(results[i].nanosecondsPerToken());
+            samples[i][2].push_back(results[i].allocationsPerToken());
+        }
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i].megabytesPerSecond = summarize(samples[i][0], !allocationTracking);
+        entries[i].nanosecondsPerToken = summarize(samples[i][1], !allocationTracking);
+        entries[i].allocationsPerToken = summarize(samples[i][2], allocationTracking);
+    }
+    return entries;
+}
+
+// Function to check whether any measured metric of an entry spreads by
+// more than its tolerance over the repetitions. Such an entry would hide
+// a regression in its own noise, so a baseline of it isn't gated on.
+bool gateEntryNoisy(const GateEntry& entry, const GateOptions& options)
+{
+    auto noisy = [](const GateMetric& metric, double tolerance) {
+        return metric.measured && metric.mad > tolerance * fabs(metric.median);
+    };
+    return noisy(entry.megabytesPerSecond, options.tolerance)
+        || noisy(entry.nanosecondsPerToken, options.tolerance)
+        || noisy(entry.allocationsPerToken, options.allocationTolerance);
+}
+
+// Function to write gate results as JSON, in the layout GateJsonReader reads
+void writeGateJson(const vector<GateEntry>& entries, const GateOptions& options, ReportWriter& out)
+{
+    out << "{\n  \"benchmark\": \"perf_gate\",\n  \"allocation_counting\": "
+        << (allocationTracking ? "true" : "false") << ",\n  \"corpus_seed\": " << options.bench.corpus.seed
+        << ",\n  \"repetitions\": " << options.repetitions << ",\n  \"results\": [\n";
+    auto writeMetric = [&](const char* key, const GateMetric& metric, unsigned precision) {
+        if (!metric.measured)
+            return;
+        out << ", \"" << key << "\": ";
+        out.fixed(metric.median, precision) << ", \"" << key << "_mad\": ";
+        out.fixed(metric.mad, precision);
+    };
+    for (size_t i = 0; i < entries.size(); i++) {
+        const GateEntry& entry = entries[i];
+        out << "    { \"name\": \"" << entry.name << "\", \"bytes\": " << entry.bytes;
+        writeMetric("mb_per_s", entry.megabytesPerSecond, 3);
+        writeMetric("ns_per_token", entry.nanosecondsPerToken, 4);
+        writeMetric("allocs_per_token", entry.allocationsPerToken, 9);
+        if (!entry.gated)
+            out << ", \"gated\": false";
+        out << " }";
+        out << (i + 1 < entries.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+// Class that reads the JSON written by writeGateJson() or writeBenchJson():
+// an object of strings, numbers and booleans with a "results" array of
+// flat objects. It is not a general JSON parser; anything else is reported
+// as an error.
+class GateJsonReader {
+private:
+    string_view text;
+    size_t position;
+    string error;
+
+    // Function to skip spaces and newlines
+    void skipSpace()
+    {
+        while (position < text.size() && isspace(static_cast<unsigned char>(text[position]))) {
+            position++;
+        }
+    }
+
+    // Function to record an error at the current position
+    bool fail(const string& message)
+    {
+        if (error.empty())
+            error = message + " at offset " + to_string(position);
+        return false;
+    }
+
+    // Function to consume a character, skipping space before it
+    bool expect(char c)
+    {
+        skipSpace();
+        if (position >= text.size() || text[position] != c)
+            return fail(string("Expected '") + c + "'");
+        position++;
+        return true;
+    }
+
+    // Function to check for a character without consuming it
+    bool peek(char c)
+    {
+        skipSpace();
+        return position < text.size() && text[position] == c;
+    }
+
+    // Function to read a string; escapes are kept as a backslash and the
+    // character after it, which is enough for case names
+    bool readString(string& value)
+    {
+        if (!expect('"'))
+            return false;
+        value.clear();
+        while (position < text.size() && text[position] != '"') {
+            if (text[position] == '\\' && position + 1 < text.size())
+                value += text[position++];
+            value += text[position++];
+        }
+        return expect('"');
+    }
+
+    // Function to read a number
+    bool readNumber(double& value)
+    {
+        skipSpace();
+        string number;
+        while (position < text.size() && (isdigit(static_cast<unsigned char>(text[position]))
+                                          || (text[position] != '\0' && strchr("+-.eE", text[position]) != nullptr))) {
+            number += text[position++];
+        }
+        char* end = nullptr;
+        value = strtod(number.c_str(), &end);
+        if (number.empty() || end != number.c_str() + number.size())
+            return fail("Expected a number");
+        return true;
+    }
+
+    // Function to read true or false
+    bool readBoolean(bool& value)
+    {
+        skipSpace();
+        for (string_view word : { "true", "false" }) {
+            if (text.substr(position, word.size()) == word) {
+                position += word.size();
+                value = word == "true";
+                return true;
+            }
+        }
+        return fail("Expected a value");
+    }
+
+    // Function to read a value that isn't needed, of any kind the files use
+    bool skipValue()
+    {
+        string ignoredText;
+        double ignoredNumber;
+        bool ignoredBoolean;
+        if (peek('"'))
+            return readString(ignoredText);
+        if (peek('t') || peek('f'))
+            return readBoolean(ignoredBoolean);
+        return readNumber(ignoredNumber);
+    }
+
+    // Function to read one result object into an entry. Missing MADs are
+    // left at zero, so plain bench_lexer results work as a baseline too.
+    // Metrics that are missing are marked as not measured.
+    bool readEntry(GateEntry& entry)
+    {
+        if (!expect('{'))
+            return false;
+        while (!peek('}')) {
+            string key;
+            if (!readString(key) || !expect(':'))
+                return false;
+            static const pair<const char*, GateMetric GateEntry::*> metrics[] = {
+                { "mb_per_s", &GateEntry::megabytesPerSecond },
+                { "ns_per_token", &GateEntry::nanosecondsPerToken },
+                { "allocs_per_token", &GateEntry::allocationsPerToken }
+            };
+            if (key == "name") {
+                if (!readString(entry.name))
+                    return false;
+            }
+            else if (key == "gated") {
+                if (!readBoolean(entry.gated))
+                    return false;
+            }
+            else if (!peek('"') && !peek('t') && !peek('f')) {
+                double value;
+                if (!readNumber(value))
+                    return false;
+                if (key == "bytes")
+                    entry.bytes = static_cast<size_t>(value);
+                for (const auto& metric : metrics) {
+                    if (key == metric.first) {
+                        (entry.*metric.second).median = value;
+                        (entry.*metric.second).measured = true;
+                    }
+                    else if (key == string(metric.first) + "_mad") {
+                        (entry.*metric.second).mad = value;
+                    }
+                }
+            }
+            else if (!skipValue()) {
+                return false;
+            }
+            if (!peek(','))
+                break;
+            position++;
+        }
+        return expect('}');
+    }
+
+public:
+
+    explicit GateJsonReader(string_view text)
+        : text(text)
+        , position(0)
+    {
+    }
+
+    // Function to read the results and the corpus seed, if the file has one.
+    // Files without a repetition count are taken as single runs.
+    bool read(vector<GateEntry>& entries, uint64_t& corpusSeed, bool& hasCorpusSeed)
+    {
+        entries.clear();
+        hasCorpusSeed = false;
+        size_t repetitions = 1;
+        if (!expect('{'))
+            return false;
+        while (!peek('}')) {
+            string key;
+            if (!readString(key) || !expect(':'))
+                return false;
+            if (key == "results") {
+                if (!expect('['))
+                    return false;
+                while (!peek(']')) {
+                    entries.emplace_back();
+                    if (!readEntry(entries.back()))
+                        return false;
+                    if (!peek(','))
+                        break;
+                    position++;
+                }
+                if (!expect(']'))
+                    return false;
+            }
+            else if (peek('"') || peek('t') || peek('f')) {
+                if (!skipValue())
+                    return false;
+            }
+            else {
+                double value;
+                if (!readNumber(value))
+                    return false;
+                if (key == "corpus_seed") {
+                    corpusSeed = static_cast<uint64_t>(value);
+                    hasCorpusSeed = true;
+                }
+                else if (key == "repetitions") {
+                    repetitions = max<size_t>(1, static_cast<size_t>(value));
+                }
+            }
+            if (!peek(','))
+                break;
+            position++;
+        }
+        for (GateEntry& entry : entries) {
+            entry.megabytesPerSecond.samples = repetitions;
+            entry.nanosecondsPerToken.samples = repetitions;
+            entry.allocationsPerToken.samples = repetitions;
+        }
+        return expect('}');
+    }
+
+    // Function to get why reading failed
+    const string& errorMessage() const { return error; }
+};
+
+// Function to check one metric against its baseline. A metric regresses
+// when it is worse by more than the tolerance and also by more than the
+// noise, the given number of standard errors of the two medians combined.
+// The noise is capped at the tolerance, so a change larger than the
+// tolerance fails however noisy the case is. Returns the relative change,
+// positive when worse.
+double checkGateMetric(const GateMetric& baseline, const GateMetric& current, bool higherIsBetter,
+                       double tolerance, double noiseFactor, bool& regressed)
+{
+    // 1.4826 scales a MAD to the standard deviation of a normal
+    // distribution, and the standard error of a median of n runs is about
+    // 1.253 / sqrt(n) of that
+    auto standardError = [](const GateMetric& metric) {
+        return 1.4826 * metric.mad * 1.253 / sqrt(static_cast<double>(max<size_t>(1, metric.samples)));
+    };
+    double limit = tolerance * fabs(baseline.median);
+    double noise = min(limit, noiseFactor * hypot(standardError(baseline), standardError(current)));
+    double worsening = higherIsBetter ? baseline.median - current.median : current.median - baseline.median;
+    regressed = worsening > limit && worsening > noise;
+    return baseline.median != 0 ? worsening / fabs(baseline.median) : 0;
+}
+
+// Function to compare a run against the baseline and print a table of
+// the changes. Metrics missing from the run or the baseline are shown as
+// dashes and not checked, and neither are entries the baseline marks as
+// not gated. Returns the number of metrics that regressed,
+// and counts the metrics that were checked in compared.
+size_t compareGate(const vector<GateEntry>& baseline, const vector<GateEntry>& current,
+                   const GateOptions& options, ReportWriter& out, size_t& compared)
+{
+    out.left("Case", 20).right("Size", 8).right("MB/s", 10).right("change", 9).right("ns/tok", 9)
+       .right("change", 9).right("alloc/tok", 11).right("change", 9) << "  Result\n";
+    out.repeat('-', 93) << '\n';
+
+    size_t regressions = 0;
+    compared = 0;
+    for (const GateEntry& entry : current) {
+        auto match = find_if(baseline.begin(), baseline.end(), [&](const GateEntry& candidate) {
+            return candidate.name == entry.name && candidate.bytes == entry.bytes;
+        });
+        out.left(entry.name, 20).right(formatByteSize(entry.bytes), 8);
+
+        // Changes are shown as the share the metric got worse by
+        string failed;
+        auto check = [&](const GateMetric& metric, const GateMetric GateEntry::* field, bool higherIsBetter,
+                         double tolerance, unsigned precision, size_t width, const char* name) {
+            if (metric.measured)
+                out.fixed(metric.median, precision, width);
+            else
+                out.right("-", width);
+            if (!metric.measured || match == baseline.end() || !(*match).gated || !((*match).*field).measured) {
+                out.right("", 9);
+                return;
+            }
+            compared++;
+            bool regressed;
+            double change = checkGateMetric((*match).*field, metric, higherIsBetter, tolerance, options.noise, regressed);
+            out.fixed(change * 100, 1, 8) << '%';
+            if (regressed) {
+                failed += ' ';
+                failed += name;
+                regressions++;
+            }
+        };
+        check(entry.megabytesPerSecond, &GateEntry::megabytesPerSecond, true, options.tolerance, 1, 10, "MB/s");
+        check(entry.nanosecondsPerToken, &GateEntry::nanosecondsPerToken, false, options.tolerance, 2, 9, "ns/tok");
+        check(entry.allocationsPerToken, &GateEntry::allocationsPerToken, false, options.allocationTolerance, 4, 11,
+              "alloc/tok");
+
+        if (match == baseline.end())
+            out << "  not in baseline\n";
+        else if (!(*match).gated)
+            out << "  not gated, noisy baseline\n";
+        else if (failed.empty())
+            out << "  ok\n";
+        else
+            out << "  REGRESSED:" << failed << '\n';
+    }
+    return regressions;
+}
+
+#endif
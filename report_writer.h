@@ -0,0 +1,221 @@
+#ifndef REPORT_WRITER_H
+#define REPORT_WRITER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "output_sink.h"
+
+using namespace std;
+
+
+// Class that formats report text by hand into a large buffer and passes
+// it on to a sink in megabyte-sized blocks. It replaces iostream
+// formatting on the print paths: nothing is flushed per line, and there
+// are no locale or width flags to consult for every value. It is a sink
+// itself, so the lexer's cleaned-up text can share its buffer.
+class ReportWriter : public OutputSink {
+private:
+    unique_ptr<FdSink> ownedSink;
+    OutputSink* target;
+    vector<char> buffer;
+    size_t used;
+
+    // Function to pass the buffered text on to the target
+    void drain()
+    {
+        if (used > 0)
+            target->write(buffer.data(), used);
+        used = 0;
+    }
+
+    // Function to get room for a number of bytes at the end of the buffer
+    char* room(size_t length)
+    {
+        if (length > buffer.size() - used)
+            drain();
+        return buffer.data() + used;
+    }
+
+    // Function to format an unsigned number, right to left, ending at end
+    static char* formatDigits(uint64_t value, char* end)
+    {
+        do {
+            *--end = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        return end;
+    }
+
+    // Function to format a number with a fixed number of decimals, right
+    // to left, ending at end. Needs up to 40 bytes. Returns null if the
+    // value times 10^precision doesn't fit in 64 bits.
+    static char* formatFixed(double value, unsigned precision, char* end)
+    {
+        if (!isfinite(value)) {
+            string_view text = isnan(value) ? "nan" : value < 0 ? "-inf" : "inf";
+            return copy_backward(text.begin(), text.end(), end);
+        }
+        bool negative = value < 0;
+        uint64_t scale = 1;
+        for (unsigned i = 0; i < precision; i++) {
+            scale *= 10;
+        }
+        double rounded = round(fabs(value) * static_cast<double>(scale));
+        if (rounded >= 18446744073709551616.0)
+            return nullptr;
+        uint64_t scaled = static_cast<uint64_t>(rounded);
+        char* start = end;
+        if (precision > 0) {
+            start = formatDigits(scaled % scale + scale, end);
+            *start = '.';   // Replaces the leading 1 of scale
+        }
+        start = formatDigits(scaled / scale, start);
+        if (negative && scaled != 0)
+            *--start = '-';
+        return start;
+    }
+
+public:
+
+    // Constructor for a writer that passes its blocks to a sink
+    explicit ReportWriter(OutputSink& sink, size_t bufferSize = 1 << 20)
+        : target(&sink)
+        , buffer(bufferSize)
+        , used(0)
+    {
+    }
+
+    // Constructor for a writer to a file descriptor. Anything still
+    // buffered in cout is flushed first, so the two stay in order.
+    explicit ReportWriter(int fd, size_t bufferSize = 1 << 20)
+        : ownedSink(new FdSink(fd, 0))
+        , target(ownedSink.get())
+        , buffer(bufferSize)
+        , used(0)
+    {
+        cout.flush();
+    }
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    ~ReportWriter() override { flush(); }
+
+    void write(const char* data, size_t length) override
+    {
+        if (length <= buffer.size() - used) {
+            memcpy(buffer.data() + used, data, length);
+            used += length;
+            return;
+        }
+        drain();
+        if (length >= buffer.size()) {
+            target->write(data, length);
+            return;
+        }
+        memcpy(buffer.data(), data, length);
+        used = length;
+    }
+
+    void flush() override
+    {
+        drain();
+        target->flush();
+    }
+
+    ReportWriter& operator<<(string_view text)
+    {
+        write(text.data(), text.size());
+        return *this;
+    }
+
+    ReportWriter& operator<<(char c)
+    {
+        *room(1) = c;
+        used++;
+        return *this;
+    }
+
+    template <typename Integer, typename = enable_if_t<is_integral<Integer>::value>>
+    ReportWriter& operator<<(Integer value)
+    {
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* start;
+        if constexpr (is_signed<Integer>::value) {
+            start = formatDigits(value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value), end);
+            if (value < 0)
+                *--start = '-';
+        }
+        else {
+            start = formatDigits(value, end);
+        }
+        write(start, static_cast<size_t>(end - start));
+        return *this;
+    }
+
+    // Function to write a character a number of times
+    ReportWriter& repeat(char c, size_t count)
+    {
+        while (count > 0) {
+            size_t length = min(count, buffer.size());
+            memset(room(length), c, length);
+            used += length;
+            count -= length;
+        }
+        return *this;
+    }
+
+    // Function to write text left-aligned in a field of the given width
+    ReportWriter& left(string_view text, size_t width)
+    {
+        write(text.data(), text.size());
+        return text.size() < width ? repeat(' ', width - text.size()) : *this;
+    }
+
+    // Function to write text right-aligned in a field of the given width
+    ReportWriter& right(string_view text, size_t width)
+    {
+        if (text.size() < width)
+            repeat(' ', width - text.size());
+        write(text.data(), text.size());
+        return *this;
+    }
+
+    // Function to write a number right-aligned in a field of the given width
+    ReportWriter& right(uint64_t value, size_t width)
+    {
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* start = formatDigits(value, end);
+        return right(string_view(start, static_cast<size_t>(end - start)), width);
+    }
+
+    // Function to write a number with a fixed number of decimals,
+    // right-aligned in a field of the given width. Values too large to
+    // format by hand go through snprintf.
+    ReportWriter& fixed(double value, unsigned precision, size_t width = 0)
+    {
+        precision = min(precision, 18u);
+        char text[48];
+        char* end = text + sizeof(text);
+        char* start = formatFixed(value, precision, end);
+        if (start != nullptr)
+            return right(string_view(start, static_cast<size_t>(end - start)), width);
+
+        char large[400];    // Enough for any double with 18 decimals
+        int length = snprintf(large, sizeof(large), "%.*f", static_cast<int>(precision), value);
+        return right(string_view(large, static_cast<size_t>(max(length, 0))), width);
+    }
+};
+
+#endif
@@ -0,0 +1,395 @@
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "report_writer.h"
+#include "perf_counters.h"
+#include "alloc_stats.h"
+
+using namespace std;
+
+
+// Function to get the peak resident set size of the process in bytes, or
+// 0 if the platform can't tell. On Linux this is VmHWM, which
+// resetPeakMemory() can lower again, so it can be read per phase.
+uint64_t readPeakMemory()
+{
+#ifdef __linux__
+    int fd = ::open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        char status[4096];
+        ssize_t length = ::read(fd, status, sizeof(status) - 1);
+        ::close(fd);
+        if (length > 0) {
+            status[length] = '\0';
+            if (const char* line = strstr(status, "VmHWM:"))
+                return strtoull(line + 6, nullptr, 10) * 1024;
+        }
+    }
+#endif
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return 0;
+}
+
+// Function to reset the peak resident set size to the current one, where
+// the platform allows it
+void resetPeakMemory()
+{
+#ifdef __linux__
+    int fd = ::open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t written = ::write(fd, "5", 1);
+        (void)written;
+        ::close(fd);
+    }
+#endif
+}
+
+// Class that records how long each phase of a run took, how many bytes it
+// handled and how much memory it peaked at, along with named counts such
+// as tokens per category. Hardware counters can be added per phase with
+// enableCounters(), and builds with LEXER_ALLOC_STATS also record the
+// allocations of each phase. Code being measured takes a RunStats pointer
+// and does nothing when it is null, so runs without --stats pay only for
+// the pointer tests.
+class RunStats {
+public:
+    // Struct to hold the measurements of one phase
+    struct Phase {
+        string name;
+        double seconds;
+        uint64_t bytes;
+        uint64_t peakMemory;    // Peak resident set size during the phase, 0 if unknown
+        PerfReading counters;   // Hardware counts, if counters are enabled
+        AllocationTotals allocations;   // Allocations made and peak live bytes during the phase
+    };
+
+    // Struct to hold a named count
+    struct Count {
+        string name;
+        uint64_t value;
+    };
+
+private:
+    vector<Phase> phases;
+    vector<Count> counts;
+    chrono::steady_clock::time_point phaseStart;
+    unique_ptr<PerfCounterGroup> counters;
+    string countersError;       // Why counters were asked for but not available
+    AllocationTotals allocationsAtStart;
+
+    // Function to write a derived metric, or a dash if it's missing
+    static void writeMetric(ReportWriter& out, double value, unsigned precision, size_t width)
+    {
+        if (value < 0)
+            out.right("-", width);
+        else
+            out.fixed(value, precision, width);
+    }
+
+    // Function to write text as a JSON string, quotes included
+    static void writeJsonString(ReportWriter& out, string_view text)
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+        out << '"';
+        for (char c : text) {
+            unsigned char byte = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (c == '\n')
+                out << "\\n";
+            else if (c == '\t')
+                out << "\\t";
+            else if (byte < 0x20)
+                out << "\\u00" << hexDigits[byte >> 4] << hexDigits[byte & 15];
+            else
+                out << c;
+        }
+        out << '"';
+    }
+
+    // Function to write a number as JSON, or null if it isn't finite
+    static void writeJsonNumber(ReportWriter& out, double value, unsigned precision)
+    {
+        if (isfinite(value))
+            out.fixed(value, precision);
+        else
+            out << "null";
+    }
+
+    // Function to get a count per input byte of a phase, or -1
+    static double perByte(const Phase& phase, PerfEvent event)
+    {
+        if (!phase.counters.valid[event] || phase.bytes == 0)
+            return -1;
+        return static_cast<double>(phase.counters.values[event]) / phase.bytes;
+    }
+
+    // Function to get the input size of the run: the most bytes any phase handled
+    uint64_t inputBytes() const
+    {
+        uint64_t bytes = 0;
+        for (const Phase& phase : phases) {
+            bytes = max(bytes, phase.bytes);
+        }
+        return bytes;
+    }
+
+    // Function to print the allocations of each phase
+    void printAllocations(ReportWriter& out) const
+    {
+        double inputMegabytes = inputBytes() / 1048576.0;
+        out.left("Phase", 12).right("Allocs", 12).right("Alloc(MB)", 12).right("Peak live(MB)", 15)
+           .right("Allocs/MB", 12).right("Bytes/MB", 12) << '\n';
+        out.repeat('-', 75) << '\n';
+        for (const Phase& phase : phases) {
+            const AllocationTotals& allocations = phase.allocations;
+            out.left(phase.name, 12).right(allocations.count, 12)
+               .fixed(allocations.bytes / 1048576.0, 3, 12).fixed(allocations.peakLiveBytes / 1048576.0, 3, 15);
+            writeMetric(out, inputMegabytes > 0 ? allocations.count / inputMegabytes : -1, 1, 12);
+            writeMetric(out, inputMegabytes > 0 ? allocations.bytes / inputMegabytes : -1, 0, 12);
+            out << '\n';
+        }
+    }
+
+    // Function to print the hardware counters of each phase
+    void printCounters(ReportWriter& out) const
+    {
+        out.left("Phase", 12).right("Cycles", 14).right("Instr", 14).right("IPC", 7)
+           .right("Cyc/B", 8).right("BrMiss%", 9).right("L1d/KB", 9).right("LLC/KB", 9) << '\n';
+        out.repeat('-', 82) << '\n';
+        for (const Phase& phase : phases) {
+            const PerfReading& reading = phase.counters;
+            out.left(phase.name, 12);
+            for (PerfEvent event : { PERF_CYCLES, PERF_INSTRUCTIONS }) {
+                if (reading.valid[event])
+                    out.right(reading.values[event], 14);
+                else
+                    out.right("-", 14);
+            }
+            writeMetric(out, reading.ratio(PERF_INSTRUCTIONS, PERF_CYCLES), 2, 7);
+            writeMetric(out, perByte(phase, PERF_CYCLES), 2, 8);
+            double missRate = reading.ratio(PERF_BRANCH_MISSES, PERF_BRANCHES);
+            writeMetric(out, missRate < 0 ? -1 : missRate * 100, 2, 9);
+            double l1 = perByte(phase, PERF_L1D_MISSES);
+            double llc = perByte(phase, PERF_LLC_MISSES);
+            writeMetric(out, l1 < 0 ? -1 : l1 * 1024, 2, 9);
+            writeMetric(out, llc < 0 ? -1 : llc * 1024, 2, 9);
+            out << '\n';
+        }
+    }
+
+public:
+
+    // Function to count hardware events in every phase from now on.
+    // Returns false if counters aren't available; the stats then say why
+    // and the run goes on without them.
+    bool enableCounters()
+    {
+        counters = make_unique<PerfCounterGroup>();
+        if (counters->open())
+            return true;
+        countersError = counters->unavailableReason();
+        counters.reset();
+        return false;
+    }
+
+    // Function to start timing a phase
+    void start(string_view name)
+    {
+        resetPeakMemory();
+        phases.push_back({ string(name), 0, 0, 0, PerfReading(), AllocationTotals() });
+        resetAllocationPeak();
+        allocationsAtStart = readAllocations();
+        phaseStart = chrono::steady_clock::now();
+        if (counters)
+            counters->start();
+    }
+
+    // Function to stop timing the current phase, recording the bytes it handled
+    void stop(uint64_t bytes = 0)
+    {
+        Phase& phase = phases.back();
+        if (counters)
+            phase.counters = counters->stop();
+        phase.seconds = chrono::duration<double>(chrono::steady_clock::now() - phaseStart).count();
+        phase.bytes = bytes;
+        phase.peakMemory = readPeakMemory();
+        AllocationTotals allocations = readAllocations();
+        phase.allocations.count = allocations.count - allocationsAtStart.count;
+        phase.allocations.bytes = allocations.bytes - allocationsAtStart.bytes;
+        phase.allocations.liveBytes = allocations.liveBytes;
+        phase.allocations.peakLiveBytes = allocations.peakLiveBytes;
+    }
+
+    // Function to add to a named count
+    void count(string_view name, uint64_t value)
+    {
+        for (Count& existing : counts) {
+            if (existing.name == name) {
+                existing.value += value;
+                return;
+            }
+        }
+        counts.push_back({ string(name), value });
+    }
+
+    // Function to get the recorded phases
+    const vector<Phase>& phaseList() const { return phases; }
+
+    // Function to get the recorded counts
+    const vector<Count>& countList() const { return counts; }
+
+    // Function to print a summary table
+    void print(ReportWriter& out) const
+    {
+        double totalSeconds = 0;
+        uint64_t peakMemory = 0;
+        out.left("Phase", 12).right("Time(ms)", 12).right("Bytes", 14).right("MB/s", 10)
+           .right("Peak RSS(MB)", 14) << '\n';
+        out.repeat('-', 62) << '\n';
+        for (const Phase& phase : phases) {
+            out.left(phase.name, 12).fixed(phase.seconds * 1e3, 3, 12).right(phase.bytes, 14);
+            if (phase.bytes > 0 && phase.seconds > 0)
+                out.fixed(phase.bytes / phase.seconds / 1e6, 1, 10);
+            else
+                out.right("-", 10);
+            out.fixed(phase.peakMemory / 1048576.0, 1, 14) << '\n';
+            totalSeconds += phase.seconds;
+            peakMemory = max(peakMemory, phase.peakMemory);
+        }
+        out.repeat('-', 62) << '\n';
+        out.left("Total", 12).fixed(totalSeconds * 1e3, 3, 12).right("", 24)
+           .fixed(peakMemory / 1048576.0, 1, 14) << '\n';
+
+        if (allocationTracking) {
+            out << '\n';
+            printAllocations(out);
+        }
+
+        if (counters) {
+            out << '\n';
+            printCounters(out);
+        }
+        else if (!countersError.empty()) {
+            out << "\nHardware counters unavailable: " << countersError << '\n';
+        }
+
+        if (!counts.empty()) {
+            out << '\n';
+            out.left("Count", 15).right("Value", 12) << '\n';
+            out.repeat('-', 27) << '\n';
+            for (const Count& entry : counts) {
+                out.left(entry.name, 15).right(entry.value, 12) << '\n';
+            }
+        }
+    }
+
+    // Function to write the phases and counts as JSON
+    void writeJson(ReportWriter& out) const
+    {
+        out << "{\n  \"phases\": [\n";
+        for (size_t i = 0; i < phases.size(); i++) {
+            const Phase& phase = phases[i];
+            out << "    { \"name\": ";
+            writeJsonString(out, phase.name);
+            out << ", \"seconds\": ";
+            writeJsonNumber(out, phase.seconds, 9);
+            out << ", \"bytes\": " << phase.bytes << ", \"mb_per_s\": ";
+            writeJsonNumber(out, phase.bytes > 0 && phase.seconds > 0 ? phase.bytes / phase.seconds / 1e6 : 0, 3);
+            out << ", \"peak_rss_bytes\": " << phase.peakMemory;
+            if (allocationTracking) {
+                out << ", \"allocations\": " << phase.allocations.count
+                    << ", \"allocated_bytes\": " << phase.allocations.bytes
+                    << ", \"peak_live_bytes\": " << phase.allocations.peakLiveBytes;
+            }
+            if (counters) {
+                const PerfReading& reading = phase.counters;
+                out << ", \"counters\": {";
+                const char* separator = " ";
+                for (size_t event = 0; event < perfEventCount; event++) {
+                    if (reading.valid[event]) {
+                        out << separator << '"' << getPerfEventName(event) << "\": " << reading.values[event];
+                        separator = ", ";
+                    }
+                }
+                // Derived metrics; missing ones are left out
+                double metrics[] = { reading.ratio(PERF_INSTRUCTIONS, PERF_CYCLES),
+                                     reading.ratio(PERF_BRANCH_MISSES, PERF_BRANCHES),
+                                     perByte(phase, PERF_CYCLES) };
+                const char* metricNames[] = { "ipc", "branch_miss_rate", "cycles_per_byte" };
+                for (size_t metric = 0; metric < 3; metric++) {
+                    if (metrics[metric] >= 0) {
+                        out << separator << '"' << metricNames[metric] << "\": ";
+                        writeJsonNumber(out, metrics[metric], 4);
+                        separator = ", ";
+                    }
+                }
+                out << " }";
+            }
+            out << " }" << (i + 1 < phases.size() ? ",\n" : "\n");
+        }
+        out << "  ],\n  \"counts\": {";
+        for (size_t i = 0; i < counts.size(); i++) {
+            out << (i > 0 ? ", " : " ");
+            writeJsonString(out, counts[i].name);
+            out << ": " << counts[i].value;
+        }
+        out << (counts.empty() ? "}" : " }");
+        if (!countersError.empty()) {
+            out << ",\n  \"counters_unavailable\": ";
+            writeJsonString(out, countersError);
+        }
+        out << "\n}\n";
+    }
+};
+
+// Function to print the stats to stderr and, given a path, write them as JSON
+void reportRunStats(const RunStats& stats, const string& jsonPath)
+{
+    {
+        ReportWriter out(fileno(stderr));
+        out << '\n';
+        stats.print(out);
+    }
+    if (jsonPath.empty())
+        return;
+
+    StringSink json;
+    {
+        ReportWriter jsonOut(json);
+        stats.writeJson(jsonOut);
+    }
+    ofstream file(jsonPath, ios::binary);
+    file << json.str();
+    if (!file)
+        cerr << "Error: " << jsonPath << " could not be written." << endl;
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "char_classes.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+
+// Kernels that find the end of a run of whitespace, word characters or
+// digits starting at p, or the end of a block comment. Each returns a pointer to the first byte in
+// [p, end) outside the run, or end. The vector versions only load whole
+// blocks that lie inside [p, end), so they never read past the buffer.
+
+// Function to find the end of a run of bytes with the given class flags, one byte at a time
+inline const char* skipCharClassScalar(const char* p, const char* end, uint8_t flags)
+{
+    while (p < end && hasCharClass(*p, flags)) {
+        p++;
+    }
+    return p;
+}
+
+inline const char* skipWhitespaceScalar(const char* p, const char* end)
+{
+    return skipCharClassScalar(p, end, CHAR_SPACE);
+}
+
+inline const char* skipWordCharsScalar(const char* p, const char* end)
+{
+    return skipCharClassScalar(p, end, CHAR_WORD);
+}
+
+inline const char* skipDigitsScalar(const char* p, const char* end)
+{
+    return skipCharClassScalar(p, end, CHAR_DIGIT);
+}
+
+// Function to find the "*/" that closes a block comment, searching for
+// each '*' with memchr. Returns a pointer to the '*', or end if there is none.
+inline const char* findCommentEndScalar(const char* p, const char* end)
+{
+    while (p < end) {
+        const char* star = static_cast<const char*>(memchr(p, '*', end - p));
+        if (star == nullptr || star + 1 >= end)
+            return end;
+        if (star[1] == '/')
+            return star;
+        p = star + 1;
+    }
+    return end;
+}
+
+#ifdef SCAN_KERNELS_X86
+
+// SSE2 masks of the bytes in a block that belong to each class
+__attribute__((target("sse2"))) inline __m128i whitespaceMask16(__m128i x)
+{
+    __m128i space = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+    __m128i tab = _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'));
+    __m128i newline = _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'));
+    __m128i carriage = _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'));
+    return _mm_or_si128(_mm_or_si128(space, tab), _mm_or_si128(newline, carriage));
+}
+
+__attribute__((target("sse2"))) inline __m128i digitMask16(__m128i x)
+{
+    // Signed compares are fine: bytes >= 0x80 are negative and fail both
+    return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('0' - 1)),
+                         _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), x));
+}
+
+__attribute__((target("sse2"))) inline __m128i wordMask16(__m128i x)
+{
+    // Setting bit 5 folds 'A'-'Z' onto 'a'-'z' without pulling in other bytes
+    __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), lower));
+    __m128i underscore = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(alpha, underscore), digitMask16(x));
+}
+
+#define SCAN_KERNEL_SSE2(name, maskFunction, scalarFunction)                        \
+    __attribute__((target("sse2"))) inline const char* name(const char* p, const char* end) \
+    {                                                                               \
+        while (end - p >= 16) {                                                     \
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));   \
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(maskFunction(block))); \
+            if (mask != 0xFFFFu)                                                    \
+                return p + __builtin_ctz(~mask);                                    \
+            p += 16;                                                                \
+        }                                                                           \
+        return scalarFunction(p, end);                                              \
+    }
+
+SCAN_KERNEL_SSE2(skipWhitespaceSse2, whitespaceMask16, skipWhitespaceScalar)
+SCAN_KERNEL_SSE2(skipWordCharsSse2, wordMask16, skipWordCharsScalar)
+SCAN_KERNEL_SSE2(skipDigitsSse2, digitMask16, skipDigitsScalar)
+
+#undef SCAN_KERNEL_SSE2
+
+// Function to find "*/" by matching '*' in one block against '/' in the
+// same block shifted by a byte
+__attribute__((target("sse2"))) inline const char* findCommentEndSse2(const char* p, const char* end)
+{
+    while (end - p >= 17) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i pair = _mm_and_si128(_mm_cmpeq_epi8(first, _mm_set1_epi8('*')),
+                                     _mm_cmpeq_epi8(second, _mm_set1_epi8('/')));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(pair));
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return findCommentEndScalar(p, end);
+}
+
+// AVX2 masks of the bytes in a block that belong to each class
+__attribute__((target("avx2"))) inline __m256i whitespaceMask32(__m256i x)
+{
+    __m256i space = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+    __m256i tab = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t'));
+    __m256i newline = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'));
+    __m256i carriage = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r'));
+    return _mm256_or_si256(_mm256_or_si256(space, tab), _mm256_or_si256(newline, carriage));
+}
+
+__attribute__((target("avx2"))) inline __m256i digitMask32(__m256i x)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('0' - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), x));
+}
+
+__attribute__((target("avx2"))) inline __m256i wordMask32(__m256i x)
+{
+    __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+    __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i underscore = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(alpha, underscore), digitMask32(x));
+}
+
+#define SCAN_KERNEL_AVX2(name, maskFunction, sse2Function)                          \
+    __attribute__((target("avx2"))) inline const char* name(const char* p, const char* end) \
+    {                                                                               \
+        while (end - p >= 32) {                                                     \
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); \
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(maskFunction(block))); \
+            if (mask != 0xFFFFFFFFu)                                                \
+                return p + __builtin_ctz(~mask);                                    \
+            p += 32;                                                                \
+        }                                                                           \
+        return sse2Function(p, end);                                                \
+    }
+
+SCAN_KERNEL_AVX2(skipWhitespaceAvx2, whitespaceMask32, skipWhitespaceSse2)
+SCAN_KERNEL_AVX2(skipWordCharsAvx2, wordMask32, skipWordCharsSse2)
+SCAN_KERNEL_AVX2(skipDigitsAvx2, digitMask32, skipDigitsSse2)
+
+#undef SCAN_KERNEL_AVX2
+
+__attribute__((target("avx2"))) inline const char* findCommentEndAvx2(const char* p, const char* end)
+{
+    while (end - p >= 33) {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i pair = _mm256_and_si256(_mm256_cmpeq_epi8(first, _mm256_set1_epi8('*')),
+                                        _mm256_cmpeq_epi8(second, _mm256_set1_epi8('/')));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(pair));
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return findCommentEndSse2(p, end);
+}
+
+#endif
+
+// Set of run-scanning kernels for one instruction set
+struct ScanKernels {
+    const char* name;
+    const char* (*skipWhitespace)(const char*, const char*);
+    const char* (*skipWordChars)(const char*, const char*);
+    const char* (*skipDigits)(const char*, const char*);
+    const char* (*findCommentEnd)(const char*, const char*);
+};
+
+// Function to get every set of kernels the CPU supports, narrowest
+// first. The scalar set is always there.
+inline const vector<const ScanKernels*>& availableScanKernels()
+{
+    static const ScanKernels scalar = { "scalar", skipWhitespaceScalar, skipWordCharsScalar, skipDigitsScalar, findCommentEndScalar };
+#ifdef SCAN_KERNELS_X86
+    static const ScanKernels sse2 = { "sse2", skipWhitespaceSse2, skipWordCharsSse2, skipDigitsSse2, findCommentEndSse2 };
+    static const ScanKernels avx2 = { "avx2", skipWhitespaceAvx2, skipWordCharsAvx2, skipDigitsAvx2, findCommentEndAvx2 };
+#endif
+
+    static const vector<const ScanKernels*> available = []() {
+        vector<const ScanKernels*> sets = { &scalar };
+#ifdef SCAN_KERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2"))
+            sets.push_back(&sse2);
+        if (__builtin_cpu_supports("avx2"))
+            sets.push_back(&avx2);
+#endif
+        return sets;
+    }();
+    return available;
+}
+
+// Function to pick the widest kernels the CPU supports. Setting the
+// LEXER_SCAN_KERNELS environment variable to "scalar" or "sse2" caps the
+// choice, which is useful for benchmarking and for comparing outputs.
+inline const ScanKernels& selectScanKernels()
+{
+    static const ScanKernels& selected = []() -> const ScanKernels& {
+        const vector<const ScanKernels*>& available = availableScanKernels();
+        const char* requested = getenv("LEXER_SCAN_KERNELS");
+        if (requested != nullptr) {
+            for (const ScanKernels* kernels : available) {
+                if (strcmp(requested, kernels->name) == 0)
+                    return *kernels;
+            }
+        }
+        return *available.back();
+    }();
+    return selected;
+}
+
+#endif
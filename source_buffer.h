@@ -0,0 +1,202 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+
+// Class that holds the text handed to the lexical analyzer, either as an
+// owned string, as a read-only memory mapping of a file, or as a borrowed
+// view of text owned elsewhere
+class SourceBuffer {
+private:
+    string text;
+    const char* mapped;         // Mapped or borrowed text, if not using text
+    size_t mappedLength;
+    bool ownsMapping;           // False for borrowed text
+
+    // Files smaller than this are cheaper to read() than to map
+    static constexpr size_t minMappedSize = 64 * 1024;
+
+    // Function to unmap the file, if one is mapped
+    void release()
+    {
+#ifndef _WIN32
+        if (mapped != nullptr && ownsMapping) {
+            munmap(const_cast<char*>(mapped), mappedLength);
+        }
+#endif
+        mapped = nullptr;
+        mappedLength = 0;
+        ownsMapping = false;
+    }
+
+#ifndef _WIN32
+    // Function to read a descriptor to the end, for pipes and small files
+    bool readAll(int fd, size_t sizeHint)
+    {
+        text.clear();
+        text.resize(sizeHint > 0 ? sizeHint + 1 : 64 * 1024);
+        size_t length = 0;
+        while (true) {
+            if (length == text.size()) {
+                text.resize(text.size() * 2);
+            }
+            ssize_t count = ::read(fd, &text[length], text.size() - length);
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            if (count == 0)
+                break;
+            length += static_cast<size_t>(count);
+        }
+        text.resize(length);
+        return true;
+    }
+#endif
+
+public:
+
+    // Constructor for an empty buffer
+    SourceBuffer()
+        : mapped(nullptr)
+        , mappedLength(0)
+        , ownsMapping(false)
+    {
+    }
+
+    // Constructor that takes ownership of an in-memory source
+    SourceBuffer(string&& source)
+        : text(move(source))
+        , mapped(nullptr)
+        , mappedLength(0)
+        , ownsMapping(false)
+    {
+    }
+
+    // Function to make a buffer that refers to text owned by someone else,
+    // which must outlive the buffer
+    static SourceBuffer borrow(string_view text)
+    {
+        SourceBuffer buffer;
+        buffer.mapped = text.data();
+        buffer.mappedLength = text.length();
+        return buffer;
+    }
+
+    SourceBuffer(SourceBuffer&& other) noexcept
+        : text(move(other.text))
+        , mapped(exchange(other.mapped, nullptr))
+        , mappedLength(exchange(other.mappedLength, 0))
+        , ownsMapping(exchange(other.ownsMapping, false))
+    {
+    }
+
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            text = move(other.text);
+            mapped = exchange(other.mapped, nullptr);
+            mappedLength = exchange(other.mappedLength, 0);
+            ownsMapping = exchange(other.ownsMapping, false);
+        }
+        return *this;
+    }
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    ~SourceBuffer() { release(); }
+
+    // Function to load a file. Regular files are mapped straight from the
+    // page cache; pipes, devices and small files fall back to read().
+    // Returns false if the file could not be opened or read.
+    bool open(const string& filename)
+    {
+        release();
+        text.clear();
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        size_t size = S_ISREG(info.st_mode) ? static_cast<size_t>(info.st_size) : 0;
+        if (size >= minMappedSize) {
+            void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                // The lexer makes a single forward pass over the file
+                madvise(address, size, MADV_SEQUENTIAL);
+                madvise(address, size, MADV_WILLNEED);
+                ::close(fd);
+                mapped = static_cast<const char*>(address);
+                mappedLength = size;
+                ownsMapping = true;
+                return true;
+            }
+        }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+        if (size > 0)
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        bool ok = readAll(fd, size);
+        ::close(fd);
+        return ok;
+#else
+        ifstream inFile(filename, ios::binary);
+        if (!inFile)
+            return false;
+        inFile.seekg(0, ios::end);
+        streamoff size = inFile.tellg();
+        inFile.seekg(0, ios::beg);
+        if (size > 0) {
+            text.resize(static_cast<size_t>(size));
+            inFile.read(&text[0], size);
+            text.resize(static_cast<size_t>(inFile.gcount()));
+        }
+        return !inFile.bad();
+#endif
+    }
+
+    // Function to replace the contents with a copy of some text, reusing
+    // the buffer's capacity. The text may be a view of this buffer.
+    void assign(string_view source)
+    {
+        text.assign(source.data(), source.size());
+        release();
+    }
+
+    // Function to get the text of the buffer
+    string_view view() const
+    {
+        if (mapped != nullptr)
+            return string_view(mapped, mappedLength);
+        return text;
+    }
+
+    // Function to check if the buffer is a file mapping
+    bool isMapped() const { return mapped != nullptr && ownsMapping; }
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+
+using namespace std;
+
+
+// Class that assigns a dense 32-bit ID to each distinct string. The
+// interner keeps its own copy of every distinct string, so IDs and the
+// text they map to stay valid after the source buffer is gone.
+class StringInterner {
+private:
+    vector<string_view> strings;    // Text of each ID
+    vector<uint32_t> hashes;        // Hash of each ID, checked before comparing text
+    vector<uint64_t> counts;        // Number of times each ID was interned
+    vector<uint32_t> slots;         // Open-addressing table of ID + 1, or 0 when empty
+    MonotonicArena storage;
+
+    // Function to copy a new distinct string into the interner's storage
+    string_view store(string_view text)
+    {
+        char* copy = storage.allocate(text.size());
+        memcpy(copy, text.data(), text.size());
+        return string_view(copy, text.size());
+    }
+
+    // Function to double the table and re-insert every ID
+    void grow()
+    {
+        slots.assign(slots.empty() ? 1024 : slots.size() * 2, 0);
+        size_t mask = slots.size() - 1;
+        for (uint32_t id = 0; id < strings.size(); id++) {
+            size_t i = hashes[id] & mask;
+            while (slots[i] != 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = id + 1;
+        }
+    }
+
+public:
+
+    // Function to hash a string (32-bit FNV-1a)
+    static uint32_t hash(string_view text)
+    {
+        uint32_t h = 2166136261u;
+        for (char c : text) {
+            h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return h;
+    }
+
+    // Function to get the ID of a string, adding it if it's new
+    uint32_t intern(string_view text) { return intern(text, 1); }
+
+    // Function to get the ID of a string that occurred a number of times
+    uint32_t intern(string_view text, uint64_t occurrences)
+    {
+        if (slots.empty())
+            grow();
+
+        uint32_t h = hash(text);
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i] != 0) {
+            uint32_t id = slots[i] - 1;
+            if (hashes[id] == h && strings[id] == text) {
+                counts[id] += occurrences;
+                return id;
+            }
+            i = (i + 1) & mask;
+        }
+
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        strings.push_back(store(text));
+        hashes.push_back(h);
+        counts.push_back(occurrences);
+        slots[i] = id + 1;
+        if (strings.size() * 2 > slots.size())
+            grow();
+        return id;
+    }
+
+    // Function to add every string of another interner, with its count.
+    // Returns the ID in this interner of each ID in the other one.
+    vector<uint32_t> merge(const StringInterner& other)
+    {
+        vector<uint32_t> remap(other.size());
+        for (uint32_t id = 0; id < other.size(); id++) {
+            remap[id] = intern(other.strings[id], other.counts[id]);
+        }
+        return remap;
+    }
+
+    // Function to remove every string, keeping the table's capacity
+    void clear()
+    {
+        strings.clear();
+        hashes.clear();
+        counts.clear();
+        fill(slots.begin(), slots.end(), 0);
+        storage.reset();
+    }
+
+    // Function to get the text of an ID
+    string_view lookup(uint32_t id) const { return strings[id]; }
+
+    // Function to get how many times an ID was interned
+    uint64_t occurrences(uint32_t id) const { return counts[id]; }
+
+    // Function to get the number of distinct strings
+    size_t size() const { return strings.size(); }
+};
+
+#endif
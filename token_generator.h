@@ -0,0 +1,112 @@
+#ifndef TOKEN_GENERATOR_H
+#define TOKEN_GENERATOR_H
+
+#include "tokenization.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+
+// Coroutine generator that yields tokens lazily, in the style of
+// std::generator. Use generateTokens() to create one.
+class TokenGenerator {
+public:
+    struct promise_type {
+        const Token* current = nullptr;
+
+        TokenGenerator get_return_object()
+        {
+            return TokenGenerator(coroutine_handle<promise_type>::from_promise(*this));
+        }
+        suspend_always initial_suspend() noexcept { return {}; }
+        suspend_always final_suspend() noexcept { return {}; }
+        suspend_always yield_value(const Token& token) noexcept
+        {
+            current = &token;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    // Iterator that resumes the coroutine each time it advances
+    class iterator {
+    private:
+        coroutine_handle<promise_type> handle;
+
+    public:
+        using iterator_category = input_iterator_tag;
+        using value_type = Token;
+        using difference_type = ptrdiff_t;
+        using pointer = const Token*;
+        using reference = const Token&;
+
+        iterator()
+            : handle(nullptr)
+        {
+        }
+
+        explicit iterator(coroutine_handle<promise_type> h)
+            : handle(h)
+        {
+        }
+
+        reference operator*() const { return *handle.promise().current; }
+        pointer operator->() const { return handle.promise().current; }
+
+        iterator& operator++()
+        {
+            handle.resume();
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(default_sentinel_t) const { return !handle || handle.done(); }
+        bool operator!=(default_sentinel_t) const { return handle && !handle.done(); }
+    };
+
+    explicit TokenGenerator(coroutine_handle<promise_type> h)
+        : handle(h)
+    {
+    }
+
+    TokenGenerator(TokenGenerator&& other) noexcept
+        : handle(exchange(other.handle, nullptr))
+    {
+    }
+
+    TokenGenerator(const TokenGenerator&) = delete;
+    TokenGenerator& operator=(const TokenGenerator&) = delete;
+
+    ~TokenGenerator()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    iterator begin()
+    {
+        handle.resume();
+        return iterator(handle);
+    }
+
+    default_sentinel_t end() { return default_sentinel; }
+
+private:
+    coroutine_handle<promise_type> handle;
+};
+
+// Function to yield the tokens of an analyzer one at a time. Destroying the
+// generator before the end simply stops lexing; the analyzer must outlive it.
+TokenGenerator generateTokens(LexicalAnalyzer& analyzer)
+{
+    Token token(TokenType::UNKNOWN, string_view());
+    while (analyzer.nextToken(token)) {
+        co_yield token;
+    }
+}
+
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <cstdint>
+#include <functional>
+
+#include "tokenization.h"
+
+using namespace std;
+
+
+// Columnar token container. Kinds, start offsets and lengths live in
+// separate packed arrays, so a pass that only looks at token kinds streams
+// one byte per token instead of a whole Token. Values are spans of the
+// source text; decoded string literals, which have no span of their own,
+// are kept in the stream and flagged in the top bit of their start offset.
+class TokenStream {
+private:
+    string_view source;
+    vector<uint8_t> kinds;
+    vector<uint64_t> starts;
+    vector<uint32_t> lengths;
+    vector<uint32_t> ids;
+    string decoded;
+
+    static constexpr uint64_t decodedBit = uint64_t(1) << 63;
+
+public:
+
+    // Function to empty the stream and point it at a new source text
+    void reset(string_view text)
+    {
+        source = text;
+        kinds.clear();
+        starts.clear();
+        lengths.clear();
+        ids.clear();
+        decoded.clear();
+    }
+
+    // Function to append a token whose value is a span of the source or a decoded literal
+    void push(TokenType type, string_view value, uint32_t id = Token::noId)
+    {
+        uint64_t start;
+        less_equal<const char*> notAfter;
+        if (notAfter(source.data(), value.data())
+            && notAfter(value.data() + value.size(), source.data() + source.size())) {
+            start = static_cast<uint64_t>(value.data() - source.data());
+        }
+        else {
+            start = decodedBit | decoded.size();
+            decoded.append(value.data(), value.size());
+        }
+        kinds.push_back(static_cast<uint8_t>(type));
+        starts.push_back(start);
+        lengths.push_back(static_cast<uint32_t>(value.size()));
+        ids.push_back(id);
+    }
+
+    // Function to get the number of tokens
+    size_t size() const { return kinds.size(); }
+
+    // Function to get the type of a token
+    TokenType type(size_t index) const { return static_cast<TokenType>(kinds[index]); }
+
+    // Function to get the value of a token
+    string_view value(size_t index) const
+    {
+        uint64_t start = starts[index];
+        if (start & decodedBit)
+            return string_view(decoded).substr(start & ~decodedBit, lengths[index]);
+        return source.substr(start, lengths[index]);
+    }
+
+    // Function to get the interned ID of a token
+    uint32_t id(size_t index) const { return ids[index]; }
+
+    // Function to get a token in the row layout
+    Token operator[](size_t index) const { return Token(type(index), value(index), ids[index]); }
+
+    // Functions to get the raw columns
+    const vector<uint8_t>& kindColumn() const { return kinds; }
+    const vector<uint64_t>& startColumn() const { return starts; }
+    const vector<uint32_t>& lengthColumn() const { return lengths; }
+    const vector<uint32_t>& idColumn() const { return ids; }
+
+    // Function to count the tokens of one type, reading only the kind column
+    size_t count(TokenType type) const
+    {
+        const uint8_t kind = static_cast<uint8_t>(type);
+        const uint8_t* data = kinds.data();
+        size_t total = 0;
+        for (size_t i = 0; i < kinds.size(); i++) {
+            total += data[i] == kind;
+        }
+        return total;
+    }
+
+    // Function to call visit(index) for every token of one type
+    template <typename Visitor>
+    void forEachOfType(TokenType type, Visitor&& visit) const
+    {
+        const uint8_t kind = static_cast<uint8_t>(type);
+        const uint8_t* data = kinds.data();
+        for (size_t i = 0; i < kinds.size(); i++) {
+            if (data[i] == kind)
+                visit(i);
+        }
+    }
+};
+
+// Function to tokenize the rest of an analyzer's input into a token stream
+void tokenizeToStream(LexicalAnalyzer& analyzer, TokenStream& stream)
+{
+    stream.reset(analyzer.text());
+    Token token(TokenType::UNKNOWN, string_view());
+    while (analyzer.nextToken(token)) {
+        stream.push(token.type, token.value, token.id);
+    }
+}
+
+// Function to print the distinct values of each token category in a
+// stream, with their counts
+void printUniqueTokens(const TokenStream& stream, ReportWriter& out) {
+    array<ValueCounter, tokenTypeCount> tokenCategories;
+
+    // Walk the kind column once per category
+    for (TokenType type : { TokenType::KEYWORD, TokenType::IDENTIFIER, TokenType::LITERAL,
+                            TokenType::OPERATOR, TokenType::SEPARATOR, TokenType::UNKNOWN }) {
+        ValueCounter& values = tokenCategories[static_cast<size_t>(type)];
+        stream.forEachOfType(type, [&](size_t index) {
+            values.add(stream.value(index), stream.id(index));
+        });
+    }
+    printTokenCategories(tokenCategories, out);
+}
+
+void printUniqueTokens(const TokenStream& stream) {
+    ReportWriter out(fileno(stdout));
+    printUniqueTokens(stream, out);
+}
+
+#endif
@@ -4,12 +4,26 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
-#include <unordered_map>
-#include <set>
-#include <iomanip>
-#include <map>
+#include <array>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "source_buffer.h"
+#include "output_sink.h"
+#include "report_writer.h"
+#include "run_stats.h"
+#include "arena.h"
+#include "string_interner.h"
+#include "value_counter.h"
+#include "keywords.h"
+#include "char_classes.h"
+#include "scan_kernels.h"
 
 using namespace std;
 
@@ -24,288 +38,635 @@ enum class TokenType {
     UNKNOWN
 };
 
+// Number of values in TokenType
+constexpr size_t tokenTypeCount = 6;
+
 // Struct to represent a token with its type and value
+// The value is a view into the source (or, for a decoded string literal,
+// the arena) kept alive by the LexicalAnalyzer that produced the token, so
+// it is only valid as long as that analyzer.
+// The id is the value's interned ID in that analyzer's symbols().
 struct Token {
     TokenType type;
-    string value;
+    uint32_t id;
+    string_view value;
+
+    static constexpr uint32_t noId = UINT32_MAX;
 
-    Token(TokenType t, const string& v)
+    Token(TokenType t, string_view v, uint32_t i = noId)
         : type(t)
+        , id(i)
         , value(v)
     {
     }
+
+    // Function to get an owned copy of the token value
+    string str() const { return string(value); }
 };
 
+class TokenIterator;
+
 // Class that implements the lexical analyzer
 class LexicalAnalyzer {
 private:
-    string input;
+    SourceBuffer source;
+    string_view input;
     size_t position;
-    unordered_map<string, TokenType> keywords;
-    string cleanedInput;
-
-
-    // Function to initialize the keywords map
-    void initKeywords()
-    {
-        keywords["int"] = TokenType::KEYWORD;
-        keywords["float"] = TokenType::KEYWORD;
-        keywords["if"] = TokenType::KEYWORD;
-        keywords["else"] = TokenType::KEYWORD;
-        keywords["while"] = TokenType::KEYWORD;
-        keywords["return"] = TokenType::KEYWORD;
-        keywords["string"] = TokenType::KEYWORD;
-        keywords["do"] = TokenType::KEYWORD;
-        keywords["void"] = TokenType::KEYWORD;
-        keywords["cout"] = TokenType::KEYWORD;
-        keywords["endl"] = TokenType::KEYWORD;
-        keywords["for"] = TokenType::KEYWORD;
-        keywords["#include"] = TokenType::KEYWORD;
-        keywords["using"] = TokenType::KEYWORD;
-        keywords["namespace"] = TokenType::KEYWORD;
-        keywords["std"] = TokenType::KEYWORD;
-        keywords["iostream"] = TokenType::KEYWORD;
-        keywords["fstream"] = TokenType::KEYWORD;
-        keywords["vector"] = TokenType::KEYWORD;
-    }
+    const ScanKernels* kernels;
+    static constexpr size_t shortRunLength = 16;
+    MonotonicArena arena;       // Decoded string literals
+    StringInterner interner;
+    bool internValues;          // Whether tokens get an interned ID
+    StringSink cleanedInput;    // Cleaned-up text, when kept in memory
+    OutputSink* cleanedSink;    // Where cleaned-up text goes, or null to drop it
+    size_t keptBegin;           // Span of the input waiting to be written to the cleaned-up text
+    size_t keptEnd;
+    bool inMultiLineComment;
+    bool inLineComment;
+    bool endOfInput;            // False while more chunks of a stream may follow
+    size_t limit;               // No token starting at or after this offset is scanned
+    string window;              // Carried-over text plus the current chunk when streaming
+
 
     // Function to check if a character is whitespace
-    bool isWhitespace(char c)
-    {
-        return c == ' ' || c == '\t' || c == '\n'
-               || c == '\r';
-    }
+    bool isWhitespace(char c) { return hasCharClass(c, CHAR_SPACE); }
 
     // Function to check if a character is alphabetic
-    bool isAlpha(char c)
-    {
-        return (c >= 'a' && c <= 'z')
-               || (c >= 'A' && c <= 'Z');
-    }
+    bool isAlpha(char c) { return hasCharClass(c, CHAR_ALPHA); }
 
     // Function to check if a character is a digit
-    bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    bool isDigit(char c) { return hasCharClass(c, CHAR_DIGIT); }
+
+    // Function to check if a character can be part of an identifier
+    bool isWordChar(char c) { return hasCharClass(c, CHAR_WORD); }
+
+    // Function to look at a character without reading past the end of the input
+    char peek(size_t index) const
+    {
+        return index < input.length() ? input[index] : '\0';
+    }
 
-    // Function to check if a character is alphanumeric
-    bool isAlphaNumeric(char c)
+    // Function to find the end of a run of bytes with the given class flags.
+    // Most runs are short, so the first bytes are checked inline and the
+    // vector kernel is only called for a run that is still going after that.
+    size_t skipRun(size_t index, uint8_t flags,
+                   const char* (*kernel)(const char*, const char*)) const
     {
-        return isAlpha(c) || isDigit(c);
+        size_t inlineEnd = min(input.length(), index + shortRunLength);
+        while (index < inlineEnd && hasCharClass(input[index], flags)) {
+            index++;
+        }
+        if (index < inlineEnd || index == input.length())
+            return index;
+        const char* text = input.data();
+        return kernel(text + index, text + input.length()) - text;
     }
 
     // Function to get the next word (identifier or keyword) from the input
-    string getNextWord()
+    string_view getNextWord()
     {
         size_t start = position;
-        while (position < input.length() && isAlphaNumeric(input[position]) && input[position] != '_') {
-            position++;
-
-        }
-        // Check if we've reached a non-word character
-        if (position < input.length() && !isAlphaNumeric(input[position])) {
-            if(position == '_' && isAlphaNumeric(input[position+1])){
-                position++;
-            }
-            string result = input.substr(start, position - start);
-            position--;
-            return result;
-        }
-        return ""; // Return empty string if no valid word found
+        position = skipRun(position, CHAR_WORD, kernels->skipWordChars);
+        return input.substr(start, position - start);
     }
 
     // Function to get the next number (integer or float) from the input
-    string getNextNumber()
+    string_view getNextNumber()
     {
         size_t start = position;
-        bool hasDecimal = false;
-        while (position < input.length()
-               && (isDigit(input[position])
-                   || input[position] == '.')) {
-            if (input[position] == '.') {
-                if (hasDecimal)
+        position = skipRun(position, CHAR_DIGIT, kernels->skipDigits);
+        // Only one decimal point belongs to the number
+        if (position < input.length() && input[position] == '.')
+            position = skipRun(position + 1, CHAR_DIGIT, kernels->skipDigits);
+        return input.substr(start, position - start);
+    }
+
+    // Function to get the contents of the string literal starting at the
+    // current quote. Literals without escapes are returned as a view of the
+    // input; a literal containing a backslash is decoded into the arena.
+    // Returns false if the input ended before the closing quote; while
+    // streaming, nothing is consumed in that case.
+    bool getNextStringLiteral(string_view& literal)
+    {
+        size_t start = position + 1; // Move past the opening quote
+        size_t end = start;
+        bool escaped = false;
+        while (end < input.length() && input[end] != '"') {
+            if (input[end] == '\\') {
+                escaped = true;
+                end++; // The escaped character can't close the literal
+            }
+            end++;
+        }
+        end = min(end, input.length());
+        bool closed = end < input.length();
+        if (!closed && !endOfInput)
+            return false;
+
+        if (!escaped) {
+            literal = input.substr(start, end - start);
+        }
+        else {
+            // Drop each backslash and keep the character after it
+            char* decoded = arena.allocate(end - start);
+            size_t length = 0;
+            for (size_t i = start; i < end; i++) {
+                if (input[i] == '\\' && ++i >= end)
                     break;
-                hasDecimal = true;
+                decoded[length++] = input[i];
             }
-            position++;
+            arena.shrink(decoded, end - start, length);
+            literal = string_view(decoded, length);
         }
-        return input.substr(start, position - start);
+        position = closed ? end + 1 : end;
+        return closed;
     }
 
+    // Function to skip to the end of a multi-line comment. Returns false if
+    // the comment is still open at the end of the input.
+    bool skipMultiLineComment()
+    {
+        const char* text = input.data();
+        const char* end = kernels->findCommentEnd(text + position, text + input.length());
+        if (end != text + input.length()) {
+            position = end - text + 2;
+            inMultiLineComment = false;
+            return true;
+        }
+        // Keep a trailing '*' in case the next chunk starts with '/'
+        if (!endOfInput && position < input.length() && input.back() == '*')
+            position = input.length() - 1;
+        else
+            position = input.length();
+        return false;
+    }
 
-public:
+    // Function to skip to the end of a single-line comment. Returns false if
+    // the input ends before the newline.
+    bool skipLineComment()
+    {
+        const char* text = input.data();
+        const void* end = memchr(text + position, '\n', input.length() - position);
+        if (end != nullptr) {
+            position = static_cast<const char*>(end) - text;
+            inLineComment = false;
+            return true;
+        }
+        position = input.length();
+        return false;
+    }
 
-    // Constructor for LexicalAnalyzer
-    LexicalAnalyzer(const string& source)
-        : input(source)
-        , position(0)
+    // Function to move past an open comment and any whitespace. Returns
+    // false if the input ends first.
+    bool skipToToken()
     {
-        initKeywords();
+        if (inMultiLineComment && !skipMultiLineComment())
+            return false;
+        if (inLineComment && !skipLineComment())
+            return false;
+
+        // Skip whitespace
+        position = skipRun(position, CHAR_SPACE, kernels->skipWhitespace);
+        return position < input.length();
     }
 
-    // Function to tokenize the input string
-    vector<Token> tokenize()
+    // Function to add the input bytes [begin, end) to the cleaned-up text.
+    // Spans that touch are merged, so a run of tokens with nothing between
+    // them is written with a single copy.
+    void keepCleaned(size_t begin, size_t end)
     {
-        vector<Token> tokens;
-        bool inMultiLineComment = false;
+        if (begin != keptEnd) {
+            flushCleaned();
+            keptBegin = begin;
+        }
+        keptEnd = end;
+    }
 
-        while (position < input.length()) {
-            char currentChar = input[position];
+    // Function to add text that doesn't appear in the input to the cleaned-up text
+    void appendCleaned(string_view text)
+    {
+        flushCleaned();
+        cleanedSink->write(text);
+    }
 
-            // Skip whitespace
-            if (isWhitespace(currentChar)) {
-                position++;
-                continue;
-            }
+    // Function to write out the pending span of the cleaned-up text
+    void flushCleaned()
+    {
+        if (keptEnd > keptBegin && cleanedSink != nullptr)
+            cleanedSink->write(input.data() + keptBegin, keptEnd - keptBegin);
+        keptBegin = keptEnd;
+    }
 
-            // Check for preprocessor directives
-            if (currentChar == '#'){
-                string directive = getNextWord();
-                    tokens.emplace_back(TokenType::KEYWORD, directive);
-                    cleanedInput += directive;
-            }
+    // Function to check if a token ending at index may continue in the next chunk
+    bool isCutOff(size_t index) const
+    {
+        return !endOfInput && index >= input.length();
+    }
 
-            // Check for multi-line comment start
-            if (currentChar == '/' && input[position+1] == '*') {
-                inMultiLineComment = true;
-                position += 2;
-            }
-            // Check for single-line comment start
-            else if (currentChar == '/' && input[position+1] == '/') {
-                // Skip until end of line
-                while (position < input.length() && input[position] != '\n') {
-                    position++;
-                }
-                continue;
-            }
+    // Function to scan the next token from the input. Returns false at the
+    // end of the input; while streaming, it also returns false when the
+    // token at the current position may continue in the next chunk.
+    bool scanToken(Token& token)
+    {
+        if (scanNextToken(token))
+            return true;
+        flushCleaned();
+        return false;
+    }
 
-            // Check for multi-line comment end
-            if (inMultiLineComment && currentChar == '*' && input[position+1] == '/') {
-                inMultiLineComment = false;
-                position += 2;
-            }
+    // Function to scan the next token, leaving the last span of cleaned-up
+    // text pending
+    bool scanNextToken(Token& token)
+    {
+        while (true) {
+            if (!skipToToken() || position >= limit)
+                return false;
 
-            // Process non-comment characters
-            if (!inMultiLineComment) {
-                // Identify keywords or identifiers
-                if (isAlpha(currentChar)) {
-                    string word = getNextWord();
-                    if (keywords.find(word) != keywords.end()) {
-                        tokens.emplace_back(TokenType::KEYWORD,
-                                            word);
-                    }
-                    else {
-                        tokens.emplace_back(
-                            TokenType::IDENTIFIER, word);
-                    }
-                    cleanedInput += word;
-                }
-                else if (isAlpha(currentChar) || currentChar == '_') {
-                    string word;
-                    while (position < input.length() && (isAlphaNumeric(input[position]) || input[position] == '_')) {
-                        word += input[position];
-                        position++;
-                    }
-                    tokens.emplace_back(TokenType::IDENTIFIER, word);
-                    cleanedInput += word;
-                }
-                // Identify integer or float literals
-                else if (isDigit(currentChar)) {
-                    string number = getNextNumber();
-                    if (number.find('.') != string::npos) {
-                        tokens.emplace_back(
-                            TokenType::LITERAL, number);
-                    }
-                    else {
-                        tokens.emplace_back(
-                            TokenType::LITERAL, number);
-                    }
-                    cleanedInput += number;
-                }
-                // Check for left shift operator
-                else if (currentChar == '<' && input[position+1] == '<') {
-                    tokens.emplace_back(TokenType::OPERATOR, "<<");
-                    cleanedInput += "<<";
+            size_t start = position;
+            char currentChar = input[position];
+            bool mayContinue = false;   // Whether the token could run on into the next chunk
+
+            switch (charDispatch[static_cast<unsigned char>(currentChar)]) {
+            // Check for comment starts, or else a division operator
+            case CharDispatch::SLASH:
+                if (isCutOff(position + 1))
+                    return false;
+                if (peek(position + 1) == '*') {
+                    inMultiLineComment = true;
                     position += 2;
+                    continue;
                 }
-                // Check for right shift operator
-                else if (currentChar == '>' && input[position+1] == '>') {
-                    tokens.emplace_back(TokenType::OPERATOR, ">>");
-                    cleanedInput += ">>";
+                if (peek(position + 1) == '/') {
+                    inLineComment = true;
                     position += 2;
+                    continue;
                 }
-                // Identify operators
-                else if (currentChar == '+'
-                        || currentChar == '-'
-                        || currentChar == '*'
-                        || currentChar == '='
-                        || currentChar == '<'
-                        || currentChar == '>'
-                        || currentChar == '^'
-                        || currentChar == '/') {
-                    tokens.emplace_back(TokenType::OPERATOR,
-                                        string(1, currentChar));
-                    cleanedInput += currentChar;
-                    position++;
-                }
+                token = Token(TokenType::OPERATOR, input.substr(position++, 1));
+                break;
 
-                // Identify separators
-                else if (currentChar == '('
-                        || currentChar == ')'
-                        || currentChar == '{'
-                        || currentChar == '}'
-                        || currentChar == ','
-                        || currentChar == ';') {
-                    tokens.emplace_back(TokenType::SEPARATOR,
-                                        string(1, currentChar));
-                    cleanedInput += currentChar;
+            // Check for preprocessor directives
+            case CharDispatch::HASH:
+                if (isCutOff(position + 1) || isAlpha(peek(position + 1))) {
                     position++;
+                    getNextWord();
+                    token = Token(TokenType::KEYWORD, input.substr(start, position - start));
+                    mayContinue = true;
                 }
-                // Identify String Literals
-                else if(currentChar == '"'){
-                    string literalString;
-                    position++;
+                else {
+                    token = Token(TokenType::UNKNOWN, input.substr(position++, 1));
+                }
+                break;
+
+            // Identify keywords or identifiers
+            case CharDispatch::WORD: {
+                string_view word = getNextWord();
+                token = Token(isKeyword(word) ? TokenType::KEYWORD : TokenType::IDENTIFIER, word);
+                mayContinue = true;
+                break;
+            }
 
-                    bool inEscapedQuote = false;
-                    while(position < input.length()) {
-                        if (input[position] == '"' && !inEscapedQuote) {
-                            // End of string literal
-                            position++; // Move past the closing quote
-                            break;
-                        } else if (input[position] == '\\') {
-                            inEscapedQuote = true;
-                            position++; // Move past the backslash
-                        } else {
-                            literalString += input[position++];
-                            inEscapedQuote = false;
-                        }
-                    }
-                    
-                    if (!literalString.empty()) {
-                        tokens.emplace_back(TokenType::LITERAL, literalString);
-                    }
-                    cleanedInput += '"' + literalString + '"';
+            // Identify integer or float literals
+            case CharDispatch::DIGIT:
+                token = Token(TokenType::LITERAL, getNextNumber());
+                mayContinue = true;
+                break;
+
+            // Check for left and right shift operators
+            case CharDispatch::ANGLE:
+                if (isCutOff(position + 1) || peek(position + 1) == currentChar) {
+                    position += 2;
+                    token = Token(TokenType::OPERATOR, input.substr(start, 2));
+                    mayContinue = true;
                 }
-                // Handle unknown characters
                 else {
-                    tokens.emplace_back(TokenType::UNKNOWN,
-                                        string(1, currentChar));
-                    cleanedInput += currentChar;
-                    position++;
+                    token = Token(TokenType::OPERATOR, input.substr(position++, 1));
+                }
+                break;
+
+            // Identify operators
+            case CharDispatch::OPERATOR:
+                token = Token(TokenType::OPERATOR, input.substr(position++, 1));
+                break;
+
+            // Identify separators
+            case CharDispatch::SEPARATOR:
+                token = Token(TokenType::SEPARATOR, input.substr(position++, 1));
+                break;
+
+            // Identify String Literals
+            case CharDispatch::QUOTE: {
+                string_view literalString;
+                bool closed = getNextStringLiteral(literalString);
+                if (!closed && !endOfInput)
+                    return false;
+                if (cleanedSink != nullptr) {
+                    if (literalString.data() == input.data() + start + 1) {
+                        keepCleaned(start, position);   // The literal as written, quotes included
+                    }
+                    else {
+                        keepCleaned(start, start + 1);
+                        appendCleaned(literalString);
+                        if (closed)
+                            keepCleaned(position - 1, position);
+                    }
+                    if (!closed)
+                        appendCleaned("\"");
                 }
-                position++;
+                if (literalString.empty())
+                    continue;
+                token = Token(TokenType::LITERAL, literalString);
+                if (internValues)
+                    token.id = interner.intern(literalString);
+                return true;
             }
+
+            // Handle unknown characters
+            default:
+                token = Token(TokenType::UNKNOWN, input.substr(position++, 1));
+                break;
+            }
+
+            // A word, number or operator that runs into the end of a chunk
+            // is picked up again once the rest of it has arrived
+            if (mayContinue && isCutOff(position)) {
+                position = start;
+                return false;
+            }
+            if (internValues)
+                token.id = interner.intern(token.value);
+            if (cleanedSink != nullptr)
+                keepCleaned(start, position);
+            return true;
         }
+    }
+
+public:
 
+    // Constructor for LexicalAnalyzer
+    LexicalAnalyzer(const string& source)
+        : LexicalAnalyzer(SourceBuffer(string(source)))
+    {
+    }
+
+    // Constructor that takes ownership of the source instead of copying it
+    LexicalAnalyzer(string&& source)
+        : LexicalAnalyzer(SourceBuffer(move(source)))
+    {
+    }
+
+    // Constructor that lexes a loaded (possibly memory-mapped) buffer in place
+    LexicalAnalyzer(SourceBuffer&& source)
+        : source(move(source))
+        , input(this->source.view())
+        , position(0)
+        , kernels(&selectScanKernels())
+        , internValues(true)
+        , cleanedSink(&cleanedInput)
+        , keptBegin(0)
+        , keptEnd(0)
+        , inMultiLineComment(false)
+        , inLineComment(false)
+        , endOfInput(true)
+        , limit(string_view::npos)
+    {
+    }
+
+    // Constructor for an analyzer that is fed its input in chunks
+    LexicalAnalyzer()
+        : LexicalAnalyzer(SourceBuffer())
+    {
+    }
+
+    // Tokens point into this analyzer, so it can't be copied, and the
+    // functions that hand out tokens or views can't be called on a
+    // temporary one
+    LexicalAnalyzer(const LexicalAnalyzer&) = delete;
+    LexicalAnalyzer& operator=(const LexicalAnalyzer&) = delete;
+
+    // Function to tokenize the input string
+    vector<Token> tokenize() &
+    {
+        vector<Token> tokens;
+        tokenize(tokens);
         return tokens;
     }
 
+    // Function to tokenize the input string into a caller's vector, reusing
+    // its capacity
+    void tokenize(vector<Token>& tokens) &
+    {
+        tokens.clear();
+        Token token(TokenType::UNKNOWN, string_view());
+
+        while (scanToken(token)) {
+            tokens.push_back(token);
+        }
+    }
+
+    vector<Token> tokenize() && = delete;
+    void tokenize(vector<Token>& tokens) && = delete;
+
+    // Function to start over on a new source. The source is copied into
+    // the analyzer's own buffer, and the buffers, arena and symbol table
+    // keep their capacity, so lexing many small snippets with one analyzer
+    // stops allocating once it has warmed up. Tokens and symbols from the
+    // previous source are invalidated.
+    void reset(string_view snippet)
+    {
+        source.assign(snippet);
+        input = source.view();
+        position = 0;
+        inMultiLineComment = false;
+        inLineComment = false;
+        endOfInput = true;
+        limit = string_view::npos;
+        internValues = true;
+        cleanedSink = &cleanedInput;
+        keptBegin = keptEnd = 0;
+        cleanedInput.clear();
+        window.clear();
+        arena.reset();
+        interner.clear();
+    }
+
+    // Function to get the text being analyzed
+    string_view text() const & { return input; }
+    string_view text() const && = delete;
+
+    // Function to get the table of interned token values
+    const StringInterner& symbols() const & { return interner; }
+    const StringInterner& symbols() const && = delete;
+
+    // Function to turn interning of token values on or off. Without it,
+    // tokens have no ID and the symbol table doesn't grow.
+    void setInternValues(bool intern) { internValues = intern; }
+
+    // Function to turn collection of the cleaned-up text in memory on or off
+    void setCollectCleanedInput(bool collect)
+    {
+        flushCleaned();
+        cleanedSink = collect ? &cleanedInput : nullptr;
+    }
+
+    // Function to send the cleaned-up text to a sink as it is produced
+    // instead of keeping it in memory. A null sink drops it entirely. The
+    // sink must outlive the analyzer or be replaced before it goes away.
+    void setCleanedSink(OutputSink* sink)
+    {
+        flushCleaned();
+        cleanedSink = sink;
+    }
+
+    // Function to restart scanning at an offset, optionally inside a
+    // multi-line comment, and stop before any token that starts at or
+    // after limit. Used to lex one slice of a buffer.
+    void seek(size_t offset, bool insideComment, size_t stopAt = string_view::npos)
+    {
+        flushCleaned();
+        position = min(offset, input.length());
+        inMultiLineComment = insideComment;
+        inLineComment = false;
+        limit = stopAt;
+    }
+
+    // Function to get the current offset into the input
+    size_t tell() const { return position; }
+
+    // Function to skip whitespace and comments, returning the offset where
+    // the next token starts (or the end of the input)
+    size_t skipToNextToken()
+    {
+        skipToToken();
+        return position;
+    }
+
+    // Function to get the cleaned-up text collected in memory so far
+    const string& cleanedText() &
+    {
+        flushCleaned();
+        return cleanedInput.str();
+    }
+    const string& cleanedText() && = delete;
+
+    // Function to get the next token on demand, so a consumer that only
+    // needs a little lookahead can stop early without lexing the rest of
+    // the input. Returns false once the input is exhausted.
+    bool nextToken(Token& token) &
+    {
+        return scanToken(token);
+    }
+    bool nextToken(Token& token) && = delete;
+
+    // Functions to iterate over the remaining tokens one at a time
+    TokenIterator begin() &;
+    TokenIterator end() &;
+    TokenIterator begin() && = delete;
+    TokenIterator end() && = delete;
+
+    // Function to lex the next chunk of a stream. Complete tokens are passed
+    // to the consumer; a token cut off by the end of the chunk, and any open
+    // comment, are carried over into the next call. Token values are only
+    // valid during the consumer call. Cleaned-up text only goes to a sink
+    // set with setCleanedSink(), and values are not interned, since the
+    // text in memory and the symbol table would grow with the stream.
+    template <typename Consumer>
+    void feed(string_view chunk, Consumer&& consumer)
+    {
+        flushCleaned();
+        window.erase(0, position);
+        window.append(chunk.data(), chunk.size());
+        input = window;
+        position = 0;
+        keptBegin = keptEnd = 0;
+        endOfInput = false;
+        if (cleanedSink == &cleanedInput)
+            cleanedSink = nullptr;
+        internValues = false;
+        arena.reset();
+
+        Token token(TokenType::UNKNOWN, string_view());
+        while (scanToken(token)) {
+            consumer(token);
+        }
+    }
+
+    // Function to lex whatever is left of the stream after the last chunk
+    template <typename Consumer>
+    void finish(Consumer&& consumer)
+    {
+        endOfInput = true;
+        Token token(TokenType::UNKNOWN, string_view());
+        while (scanToken(token)) {
+            consumer(token);
+        }
+    }
+
         // New method to display cleaned-up text
     void printCleanedInput() {
-        cout << "Cleaned-up Input:\n" << cleanedInput << "\n\n";
+        ReportWriter out(fileno(stdout));
+        printCleanedInput(out);
+    }
+
+    // Function to write the cleaned-up text to a report
+    void printCleanedInput(ReportWriter& out) {
+        out << "Cleaned-up Input:\n" << cleanedText() << "\n\n";
     }
 };
 
+// Input iterator that pulls tokens from a LexicalAnalyzer as it advances
+class TokenIterator {
+private:
+    LexicalAnalyzer* analyzer;
+    Token current;
+
+public:
+    using iterator_category = input_iterator_tag;
+    using value_type = Token;
+    using difference_type = ptrdiff_t;
+    using pointer = const Token*;
+    using reference = const Token&;
+
+    // Constructor for the end iterator
+    TokenIterator()
+        : analyzer(nullptr)
+        , current(TokenType::UNKNOWN, string_view())
+    {
+    }
+
+    // Constructor that reads the first token of the analyzer
+    explicit TokenIterator(LexicalAnalyzer& source)
+        : analyzer(&source)
+        , current(TokenType::UNKNOWN, string_view())
+    {
+        ++*this;
+    }
+
+    reference operator*() const { return current; }
+    pointer operator->() const { return &current; }
+
+    TokenIterator& operator++()
+    {
+        if (!analyzer->nextToken(current))
+            analyzer = nullptr;
+        return *this;
+    }
+
+    TokenIterator operator++(int)
+    {
+        TokenIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    bool operator==(const TokenIterator& other) const { return analyzer == other.analyzer; }
+    bool operator!=(const TokenIterator& other) const { return analyzer != other.analyzer; }
+};
+
+inline TokenIterator LexicalAnalyzer::begin() & { return TokenIterator(*this); }
+inline TokenIterator LexicalAnalyzer::end() & { return TokenIterator(); }
+
 // Function to convert TokenType to string for printing
-string getTokenTypeName(TokenType type)
+string_view getTokenTypeName(TokenType type)
 {
     switch (type) {
     case TokenType::KEYWORD:
@@ -326,71 +687,144 @@ string getTokenTypeName(TokenType type)
 }
 
 // Function to print all tokens
-void printTokens(const vector<Token>& tokens)
+void printTokens(const vector<Token>& tokens, ReportWriter& out)
 {
     for (const auto& token : tokens) {
-        cout << "Type: " << getTokenTypeName(token.type)
-             << ", Value: " << token.value << endl;
+        out << "Type: " << getTokenTypeName(token.type)
+            << ", Value: " << token.value << '\n';
     }
 }
 
-void printUniqueTokens(const vector<Token>& tokens) {
-    // Create a map to group tokens by category
-    map<TokenType, set<string>> tokenCategories;
+void printTokens(const vector<Token>& tokens)
+{
+    ReportWriter out(fileno(stdout));
+    printTokens(tokens, out);
+}
 
-    // Group tokens by category
-    for (const auto& token : tokens) {
-        tokenCategories[token.type].insert(token.value);
-    }
+// Function to print the distinct values of each token category, sorted,
+// with the number of times each one occurred
+void printTokenCategories(const array<ValueCounter, tokenTypeCount>& tokenCategories, ReportWriter& out) {
     // Print header
-    cout << left << setw(15) << "Category"
-          << left << setw(15) << "Tokens" << endl;
+    out.left("Category", 15).left("Tokens", 15) << '\n';
 
     // Print separator
-    cout << string(35, '-') << endl;
+    out.repeat('-', 35) << '\n';
 
     // Print each category
-    for (const auto& pair : tokenCategories) {
-        const TokenType& type = pair.first;
-        const set<string>& values = pair.second;
+    for (size_t type = 0; type < tokenTypeCount; type++) {
+        if (tokenCategories[type].empty())
+            continue;
 
-        cout << left << setw(15) << getTokenTypeName(type)
-              << left << setw(2);
+        out.left(getTokenTypeName(static_cast<TokenType>(type)), 15);
 
         // Print tokens for this category
-        for (const auto& value : values) {
-            cout << value << "   ";
+        for (const auto& entry : tokenCategories[type].sorted()) {
+            out << entry.value << " (" << entry.count << ")   ";
         }
-        cout << endl;
+        out << '\n';
     }
 }
 
-// Function to read from file
-void tokenizeFile(const string& filename){
-
-    ifstream inFile(filename);  // Open text file
-    if(!inFile){    // If text file can't be opened, return error message
-        cerr << "Error: File could not be opened." << endl;
-        return;
+// Function to count the distinct values of each token category. Tokens
+// must come from the same analyzer, since values are looked up by ID.
+array<ValueCounter, tokenTypeCount> countUniqueTokens(const vector<Token>& tokens) {
+    // Count tokens by category, only hashing strings for new IDs
+    array<ValueCounter, tokenTypeCount> tokenCategories;
+    for (const auto& token : tokens) {
+        tokenCategories[static_cast<size_t>(token.type)].add(token.value, token.id);
     }
+    return tokenCategories;
+}
 
-    string fileContent((istreambuf_iterator<char>(inFile)), {}); // Read contents of opened text file into string    
-    inFile.close(); // Close text file
+// Function to print the distinct values of each token category with their
+// counts. Tokens must come from the same analyzer, since values are looked
+// up by ID.
+void printUniqueTokens(const vector<Token>& tokens, ReportWriter& out) {
+    printTokenCategories(countUniqueTokens(tokens), out);
+}
 
-    LexicalAnalyzer textFile(fileContent);
+void printUniqueTokens(const vector<Token>& tokens) {
+    ReportWriter out(fileno(stdout));
+    printUniqueTokens(tokens, out);
+}
 
-    // Tokenize the file content
-    vector<Token> tokens = textFile.tokenize();
+// Function to read from file. With stats, the time, bytes and peak memory
+// of each phase are recorded, along with the tokens of each category.
+// The cleaned-up text is written while lexing, so it is part of the lex
+// phase.
+void tokenizeFile(const string& filename, RunStats* stats = nullptr){
 
-    // Print modified file
-    textFile.printCleanedInput();
+    if (stats)
+        stats->start("read");
+    SourceBuffer fileContent;   // Map or read the text file without copying it
+    if(!fileContent.open(filename)){    // If text file can't be opened, return error message
+        cerr << "Error: File could not be opened." << endl;
+        if (stats)
+            stats->stop();
+        return;
+    }
+    size_t bytes = fileContent.view().length();
+    if (stats)
+        stats->stop(bytes);
+
+    LexicalAnalyzer textFile(move(fileContent));
+
+    // Tokenize the file content, writing the modified file out in large
+    // blocks as it is produced
+    if (stats)
+        stats->start("lex");
+    ReportWriter out(fileno(stdout));
+    out << "Cleaned-up Input:\n";
+    textFile.setCleanedSink(&out);
+    vector<Token> tokens = textFile.tokenize();
+    textFile.setCleanedSink(nullptr);
+    out << "\n\n";
+    if (stats)
+        stats->stop(bytes);
+
+    // Count the distinct tokens of each category
+    if (stats)
+        stats->start("aggregate");
+    array<ValueCounter, tokenTypeCount> tokenCategories = countUniqueTokens(tokens);
+    if (stats)
+        stats->stop();
 
     // Print all identified tokens
-    cout << endl;
-    printUniqueTokens(tokens);
-    cout << endl;
+    if (stats)
+        stats->start("print");
+    out << '\n';
+    printTokenCategories(tokenCategories, out);
+    out << '\n';
+    out.flush();
+    if (stats) {
+        stats->stop();
+        array<uint64_t, tokenTypeCount> countsByType = {};
+        for (const auto& token : tokens) {
+            countsByType[static_cast<size_t>(token.type)]++;
+        }
+        for (size_t type = 0; type < tokenTypeCount; type++) {
+            stats->count(getTokenTypeName(static_cast<TokenType>(type)), countsByType[type]);
+        }
+    }
 
     return;
 }
 
-#endif
\ No newline at end of file
+// Function to lex a stream in fixed-size chunks, passing each token to the
+// consumer and, if given, the cleaned-up text to a sink. Memory use stays
+// bounded by the chunk size plus the longest token.
+template <typename Consumer>
+void tokenizeStream(istream& in, Consumer&& consumer, size_t chunkSize = 1 << 20,
+                    OutputSink* cleanedSink = nullptr)
+{
+    LexicalAnalyzer analyzer;
+    analyzer.setCleanedSink(cleanedSink);
+    vector<char> chunk(max<size_t>(1, chunkSize));
+
+    while (in.read(chunk.data(), chunk.size()) || in.gcount() > 0) {
+        analyzer.feed(string_view(chunk.data(), static_cast<size_t>(in.gcount())), consumer);
+    }
+    analyzer.finish(consumer);
+}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef VALUE_COUNTER_H
+#define VALUE_COUNTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "string_interner.h"
+
+using namespace std;
+
+
+// Class that counts how many times each distinct string value occurs, in
+// an open-addressing hash table. Values are not copied, so the text they
+// point into must outlive the counter. Values that come with an interned
+// ID are found by ID, without hashing or comparing the text.
+class ValueCounter {
+public:
+    // Struct to hold one distinct value and its count
+    struct Entry {
+        string_view value;
+        uint32_t hash;
+        uint64_t count;
+    };
+
+    static constexpr uint32_t noId = UINT32_MAX;
+
+private:
+    vector<Entry> entries;
+    vector<uint32_t> slots;         // Open-addressing table of entry index + 1, or 0 when empty
+    vector<uint32_t> entryOfId;     // Entry index + 1 of each interned ID seen, or 0
+
+    // Function to double the table and re-insert every entry
+    void grow()
+    {
+        slots.assign(slots.empty() ? 64 : slots.size() * 2, 0);
+        size_t mask = slots.size() - 1;
+        for (uint32_t index = 0; index < entries.size(); index++) {
+            size_t i = entries[index].hash & mask;
+            while (slots[i] != 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = index + 1;
+        }
+    }
+
+    // Function to find the entry of a value, adding it if it's new
+    uint32_t find(string_view value)
+    {
+        if (slots.empty())
+            grow();
+
+        uint32_t h = StringInterner::hash(value);
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i] != 0) {
+            uint32_t index = slots[i] - 1;
+            if (entries[index].hash == h && entries[index].value == value)
+                return index;
+            i = (i + 1) & mask;
+        }
+
+        uint32_t index = static_cast<uint32_t>(entries.size());
+        entries.push_back({ value, h, 0 });
+        slots[i] = index + 1;
+        if (entries.size() * 2 > slots.size())
+            grow();
+        return index;
+    }
+
+    // Function to get the byte of a value at a depth, or 0 past its end
+    static size_t bucketOf(const Entry& entry, size_t depth)
+    {
+        return depth < entry.value.size() ? static_cast<unsigned char>(entry.value[depth]) + 1 : 0;
+    }
+
+    // Function to sort entries by value with an MSD radix sort on one byte
+    // per level. Groups waiting to be sorted are kept on an explicit stack
+    // rather than by recursion, so values with long shared prefixes can't
+    // overflow the call stack. Small groups are finished with a comparison
+    // sort.
+    static void radixSort(Entry* first, Entry* last, vector<Entry>& scratch)
+    {
+        struct Group {
+            Entry* first;
+            Entry* last;
+            size_t depth;           // Bytes every entry of the group agrees on
+        };
+        vector<Group> pending = { { first, last, 0 } };
+
+        while (!pending.empty()) {
+            Group group = pending.back();
+            pending.pop_back();
+            size_t count = static_cast<size_t>(group.last - group.first);
+            size_t depth = group.depth;
+            if (count < 32) {
+                sort(group.first, group.last, [depth](const Entry& a, const Entry& b) {
+                    return a.value.substr(min(depth, a.value.size())) < b.value.substr(min(depth, b.value.size()));
+                });
+                continue;
+            }
+
+            // Skip over bytes the whole group shares, without distributing
+            size_t offsets[258];
+            while (true) {
+                fill(offsets, offsets + 258, 0);
+                for (Entry* entry = group.first; entry != group.last; entry++) {
+                    offsets[bucketOf(*entry, depth) + 1]++;
+                }
+                size_t largest = *max_element(offsets + 2, offsets + 258);
+                if (largest != count)
+                    break;
+                depth++;
+            }
+            for (size_t bucket = 1; bucket < 258; bucket++) {
+                offsets[bucket] += offsets[bucket - 1];
+            }
+
+            scratch.resize(count);
+            size_t next[257];
+            copy(offsets, offsets + 257, next);
+            for (Entry* entry = group.first; entry != group.last; entry++) {
+                scratch[next[bucketOf(*entry, depth)]++] = *entry;
+            }
+            copy(scratch.begin(), scratch.begin() + count, group.first);
+
+            // Values that ended at this depth are equal, so only the byte buckets need more work
+            for (size_t bucket = 1; bucket < 257; bucket++) {
+                if (offsets[bucket + 1] - offsets[bucket] > 1)
+                    pending.push_back({ group.first + offsets[bucket], group.first + offsets[bucket + 1], depth + 1 });
+            }
+        }
+    }
+
+public:
+
+    // Function to count a value, optionally with its interned ID
+    void add(string_view value, uint32_t id = noId, uint64_t occurrences = 1)
+    {
+        if (id == noId) {
+            entries[find(value)].count += occurrences;
+            return;
+        }
+        if (id >= entryOfId.size())
+            entryOfId.resize(static_cast<size_t>(id) + 1, 0);
+        if (entryOfId[id] == 0)
+            entryOfId[id] = find(value) + 1;
+        entries[entryOfId[id] - 1].count += occurrences;
+    }
+
+    // Function to get the number of distinct values
+    size_t size() const { return entries.size(); }
+
+    // Function to check if nothing has been counted
+    bool empty() const { return entries.empty(); }
+
+    // Function to get the distinct values with their counts, sorted by value
+    vector<Entry> sorted() const
+    {
+        vector<Entry> result = entries;
+        vector<Entry> scratch;
+        radixSort(result.data(), result.data() + result.size(), scratch);
+        return result;
+    }
+
+    // Function to remove every value, keeping the table's capacity
+    void clear()
+    {
+        entries.clear();
+        fill(slots.begin(), slots.end(), 0);
+        entryOfId.clear();
+    }
+};
+
+#endif
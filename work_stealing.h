@@ -0,0 +1,142 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+// Struct to hold what one worker did during a scheduler run
+struct WorkerStats {
+    size_t tasks;
+    size_t steals;
+    uint64_t cost;          // Sum of the costs of the tasks it ran
+    double busySeconds;
+    double wallSeconds;
+
+    WorkerStats()
+        : tasks(0)
+        , steals(0)
+        , cost(0)
+        , busySeconds(0)
+        , wallSeconds(0)
+    {
+    }
+
+    // Function to get the share of the run this worker spent running tasks
+    double utilization() const { return wallSeconds > 0 ? busySeconds / wallSeconds : 0; }
+};
+
+// Class that runs a set of tasks with known relative costs on a pool of
+// threads. Every worker has its own deque, seeded largest task first, and
+// takes work from the front of it. A worker whose deque runs dry steals
+// from the back of the others, so a thread stuck on one huge task doesn't
+// hold up the rest of its share.
+class WorkStealingScheduler {
+private:
+    struct WorkerQueue {
+        mutex lock;
+        deque<size_t> tasks;
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues;
+
+    // Function to take the next task from a worker's own deque
+    bool popOwn(size_t worker, size_t& task)
+    {
+        WorkerQueue& queue = *queues[worker];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+            return false;
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    // Function to take a task from another worker's deque
+    bool steal(size_t thief, size_t& task)
+    {
+        for (size_t offset = 1; offset < queues.size(); offset++) {
+            WorkerQueue& queue = *queues[(thief + offset) % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if (!queue.tasks.empty()) {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+
+    // Function to call runTask(index) once for every task on the given
+    // number of threads. Returns the statistics of each worker.
+    template <typename Task>
+    vector<WorkerStats> run(const vector<uint64_t>& costs, unsigned threads, Task&& runTask)
+    {
+        size_t workerCount = max<size_t>(1, min<size_t>(threads, costs.size()));
+        vector<WorkerStats> stats(workerCount);
+        if (costs.empty())
+            return stats;
+
+        // Deal the tasks out round-robin, largest first
+        vector<size_t> order(costs.size());
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(),
+                    [&](size_t a, size_t b) { return costs[a] > costs[b]; });
+
+        queues.clear();
+        for (size_t i = 0; i < workerCount; i++) {
+            queues.push_back(make_unique<WorkerQueue>());
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+            queues[i % workerCount]->tasks.push_back(order[i]);
+        }
+
+        auto startTime = chrono::steady_clock::now();
+        auto worker = [&](size_t id) {
+            WorkerStats& mine = stats[id];
+            size_t task;
+            while (true) {
+                bool stolen = false;
+                if (!popOwn(id, task)) {
+                    if (!steal(id, task))
+                        break;
+                    stolen = true;
+                }
+                auto taskStart = chrono::steady_clock::now();
+                runTask(task);
+                mine.busySeconds += chrono::duration<double>(chrono::steady_clock::now() - taskStart).count();
+                mine.tasks++;
+                mine.steals += stolen;
+                mine.cost += costs[task];
+            }
+        };
+
+        vector<thread> workers;
+        for (size_t i = 1; i < workerCount; i++) {
+            workers.emplace_back(worker, i);
+        }
+        worker(0);
+        for (thread& t : workers) {
+            t.join();
+        }
+
+        double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        for (WorkerStats& worker : stats) {
+            worker.wallSeconds = wallSeconds;
+        }
+        return stats;
+    }
+};
+
+#endif